@@ -0,0 +1,202 @@
+////////////////////////////////////////////////////////////////////////////////
+//
+// The MIT License (MIT)
+// 
+// Copyright (c) 2015 Matt Bolt
+// 
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+// 
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+// 
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+////////////////////////////////////////////////////////////////////////////////
+
+// Cross-thread forwarding throughput: producer threads dispatch on their own dispatchers, and a consumer thread
+// delivers everything through one target dispatcher. Channels (lock-free rings drained in batches) are compared
+// against forwarding through a mutex protected std::deque. Prints CSV:
+//
+//     benchmark,variant,producers,capacity,value,unit
+
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include "channel.h"
+
+using namespace dispatch;
+
+namespace {
+
+    struct tick_signal : public signal {
+        std::uint32_t producer;
+        std::uint32_t sequence;
+
+        tick_signal(std::uint32_t _producer, std::uint32_t _sequence) 
+            : signal(), producer(_producer), sequence(_sequence) { }
+    };
+
+    const std::uint32_t signals_per_producer = 2000000;
+    const std::size_t capacity = 4096;
+
+    /**
+     * Counts deliveries on the target and checks that each producer's signals arrive in order.
+     */
+    struct order_check {
+        std::vector<std::uint32_t> next;
+        std::uint64_t delivered;
+        std::uint64_t out_of_order;
+
+        explicit order_check(std::size_t producers) 
+            : next(producers, 0), delivered(0), out_of_order(0) { }
+
+        void operator()(const tick_signal& s) {
+            if (s.sequence != next[s.producer]) {
+                ++out_of_order;
+            }
+            next[s.producer] = s.sequence + 1;
+            ++delivered;
+        }
+    };
+
+    void report(const char* variant, std::size_t producers, double seconds, const order_check& check) {
+        std::printf("forward,%s,%zu,%zu,%.0f,signals/s\n", variant, producers, capacity, check.delivered / seconds);
+        if (check.out_of_order != 0) {
+            std::printf("forward,%s,%zu,%zu,%llu,out_of_order\n", variant, producers, capacity, 
+                static_cast<unsigned long long>(check.out_of_order));
+        }
+    }
+
+    /**
+     * Runs <code>producers</code> threads, each dispatching on its own source, while the calling thread runs 
+     * <code>drain</code> until every signal has been delivered. Returns the elapsed seconds.
+     */
+    template<class Drain>
+    double run(std::vector<std::unique_ptr<dispatcher>>& sources, order_check& check, Drain drain) {
+        const std::uint64_t total = std::uint64_t(signals_per_producer) * sources.size();
+
+        auto start = std::chrono::steady_clock::now();
+
+        std::vector<std::thread> threads;
+        for (std::size_t p = 0; p < sources.size(); ++p) {
+            dispatcher* source = sources[p].get();
+            threads.emplace_back([source, p]() {
+                for (std::uint32_t i = 0; i < signals_per_producer; ++i) {
+                    source->dispatch(tick_signal(static_cast<std::uint32_t>(p), i));
+                }
+            });
+        }
+
+        while (check.delivered < total) {
+            if (drain() == 0) {
+                std::this_thread::yield();
+            }
+        }
+
+        auto elapsed = std::chrono::steady_clock::now() - start;
+        for (std::thread& t : threads) {
+            t.join();
+        }
+
+        return std::chrono::duration<double>(elapsed).count();
+    }
+
+    std::vector<std::unique_ptr<dispatcher>> make_sources(std::size_t producers) {
+        std::vector<std::unique_ptr<dispatcher>> sources;
+        for (std::size_t i = 0; i < producers; ++i) {
+            sources.emplace_back(new dispatcher());
+        }
+
+        return sources;
+    }
+
+    //----------------------------------
+    //  Benchmarks
+    //----------------------------------
+
+    template<class Channel>
+    void bench_channel(const char* variant, std::size_t producers) {
+        std::vector<std::unique_ptr<dispatcher>> sources = make_sources(producers);
+        dispatcher target;
+        order_check check(producers);
+        target.add(listener<tick_signal>([&check](const tick_signal& s) { check(s); }, 1));
+
+        Channel channel(target, capacity);
+        for (auto& source : sources) {
+            channel.connect(*source);
+        }
+
+        double seconds = run(sources, check, [&channel]() { return channel.pump(); });
+        report(variant, producers, seconds, check);
+    }
+
+    /**
+     * The baseline: each source pushes into a mutex protected deque, and the consumer swaps the deque out under 
+     * the lock and dispatches what it took.
+     */
+    void bench_mutex(std::size_t producers) {
+        std::vector<std::unique_ptr<dispatcher>> sources = make_sources(producers);
+        dispatcher target;
+        order_check check(producers);
+        target.add(listener<tick_signal>([&check](const tick_signal& s) { check(s); }, 1));
+
+        std::mutex lock;
+        std::deque<tick_signal> queue;
+        std::deque<tick_signal> taken;
+
+        auto forward = [&lock, &queue](const tick_signal& s) {
+            std::lock_guard<std::mutex> guard(lock);
+            queue.push_back(s);
+        };
+        for (auto& source : sources) {
+            source->add(listener<tick_signal>(forward, 1));
+        }
+
+        double seconds = run(sources, check, [&]() {
+            {
+                std::lock_guard<std::mutex> guard(lock);
+                taken.swap(queue);
+            }
+
+            std::size_t count = taken.size();
+            for (const tick_signal& s : taken) {
+                target.dispatch(s);
+            }
+            taken.clear();
+
+            return count;
+        });
+        report("mutex_deque", producers, seconds, check);
+    }
+
+};
+
+int main() {
+    std::printf("benchmark,variant,producers,capacity,value,unit\n");
+
+    bench_mutex(1);
+    bench_channel<spsc_channel<tick_signal>>("spsc_channel", 1);
+    bench_channel<mpsc_channel<tick_signal>>("mpsc_channel", 1);
+
+    bench_mutex(4);
+    bench_channel<mpsc_channel<tick_signal>>("mpsc_channel", 4);
+
+    return 0;
+}
@@ -0,0 +1,397 @@
+////////////////////////////////////////////////////////////////////////////////
+//
+// The MIT License (MIT)
+// 
+// Copyright (c) 2015 Matt Bolt
+// 
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+// 
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+// 
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+////////////////////////////////////////////////////////////////////////////////
+
+// Core dispatch benchmarks. Every measurement is printed as one CSV row so results can be collected and compared
+// across versions:
+//
+//     benchmark,variant,listeners,payload_bytes,value,unit
+//
+// The same source is built a second time with DISPATCH_INSTRUMENTATION defined (dispatch_bench_instrumented),
+// so comparing the two runs shows what instrumentation costs, and that it costs nothing when compiled out.
+
+#include <chrono>
+#include <cstdio>
+#include <cstdint>
+#include <cstdlib>
+#include <new>
+#include <vector>
+#include "dispatcher.h"
+#include "static_dispatcher.h"
+
+using namespace dispatch;
+
+/**
+ * Keyed by entity, for the keyed dispatch benchmark. Keys have to be declared at global scope.
+ */
+struct entity_signal : public signal {
+    std::uint32_t entity;
+
+    entity_signal(std::uint32_t _entity) : signal(), entity(_entity) { }
+};
+
+DISPATCH_SIGNAL_KEY(entity_signal, entity)
+
+/**
+ * The same payload as <code>payload_signal&lt;8&gt;</code>, passed as arguments.
+ */
+struct value_event : public event<std::uint64_t> { };
+
+//----------------------------------
+//  Allocation Tracking
+//----------------------------------
+
+// GCC can't see that the replaced operator new below pairs with the replaced operator delete.
+#if defined(__GNUC__) && !defined(__clang__) && __GNUC__ >= 11
+#pragma GCC diagnostic ignored "-Wmismatched-new-delete"
+#endif
+
+static std::size_t g_allocated_bytes = 0;
+static std::size_t g_allocations = 0;
+
+void* operator new(std::size_t size) {
+    g_allocated_bytes += size;
+    ++g_allocations;
+
+    if (void* p = std::malloc(size)) {
+        return p;
+    }
+    throw std::bad_alloc();
+}
+
+void operator delete(void* p) noexcept {
+    std::free(p);
+}
+
+void operator delete(void* p, std::size_t) noexcept {
+    std::free(p);
+}
+
+namespace {
+
+    //----------------------------------
+    //  Signals and Listeners
+    //----------------------------------
+
+    std::uint64_t g_sink = 0;
+
+    template<std::size_t N>
+    struct payload_signal : public signal {
+        std::uint64_t value;
+        char data[N];
+
+        payload_signal(std::uint64_t _value) : signal(), value(_value) { 
+            data[0] = static_cast<char>(_value);
+        }
+    };
+
+    typedef payload_signal<8> small_signal;
+
+    void free_listener(const small_signal& s) {
+        g_sink += s.value;
+    }
+
+    struct member_listener {
+        std::uint64_t bias;
+
+        void on_signal(const small_signal& s) {
+            g_sink += s.value + bias;
+        }
+    };
+
+    //----------------------------------
+    //  Reporting
+    //----------------------------------
+
+    void report(const char* benchmark, const char* variant, std::size_t listeners, std::size_t payload, double value, const char* unit) {
+        std::printf("%s,%s,%zu,%zu,%.3f,%s\n", benchmark, variant, listeners, payload, value, unit);
+    }
+
+    /**
+     * Runs <code>fn</code> <code>iterations</code> times after a short warm up, and returns nanoseconds per call.
+     */
+    template<class F>
+    double measure(std::size_t iterations, const F& fn) {
+        for (std::size_t i = 0; i < iterations / 10 + 1; ++i) {
+            fn(i);
+        }
+
+        auto start = std::chrono::steady_clock::now();
+        for (std::size_t i = 0; i < iterations; ++i) {
+            fn(i);
+        }
+        auto elapsed = std::chrono::steady_clock::now() - start;
+
+        return std::chrono::duration<double, std::nano>(elapsed).count() / iterations;
+    }
+
+    std::size_t iterations_for(std::size_t listeners) {
+        return std::max<std::size_t>(1000, 20000000 / (listeners + 1));
+    }
+
+    //----------------------------------
+    //  Benchmarks
+    //----------------------------------
+
+    /**
+     * Dispatch latency and listener throughput against fan-out.
+     */
+    void bench_fanout() {
+        const std::size_t fanouts[] = { 0, 1, 10, 1000 };
+
+        for (std::size_t count : fanouts) {
+            auto l = [](const small_signal& s) { g_sink += s.value; };
+            std::vector<decltype(l)> listeners(count, l);
+
+            dispatcher d;
+            for (const auto& listener : listeners) {
+                d += listener;
+            }
+
+            double ns = measure(iterations_for(count), [&d](std::size_t i) { d.dispatch(small_signal(i)); });
+            report("fanout", "latency", count, sizeof(small_signal), ns, "ns/dispatch");
+            report("fanout", "throughput", count, sizeof(small_signal), count * 1e9 / ns, "calls/s");
+        }
+    }
+
+    template<std::size_t N>
+    void bench_payload(std::size_t count) {
+        typedef payload_signal<N> S;
+
+        auto l = [](const S& s) { g_sink += s.value; };
+        std::vector<decltype(l)> listeners(count, l);
+
+        dispatcher d;
+        for (const auto& listener : listeners) {
+            d += listener;
+        }
+
+        S s(1);
+        double ns = measure(iterations_for(count), [&d, &s](std::size_t i) { s.value = i; d.dispatch(s); });
+        report("payload", "latency", count, sizeof(S), ns, "ns/dispatch");
+    }
+
+    /**
+     * Dispatch cost per listener kind, with 10 listeners of the same kind.
+     */
+    void bench_listener_kinds() {
+        const std::size_t count = 10;
+        const std::size_t iterations = iterations_for(count);
+
+        {
+            auto l = [](const small_signal& s) { g_sink += s.value; };
+            std::vector<decltype(l)> listeners(count, l);
+
+            dispatcher d;
+            for (const auto& listener : listeners) {
+                d += listener;
+            }
+            report("kind", "lambda", count, sizeof(small_signal), measure(iterations, [&d](std::size_t i) { d.dispatch(small_signal(i)); }), "ns/dispatch");
+        }
+
+        {
+            auto b = std::bind(&free_listener, std::placeholders::_1);
+            std::vector<decltype(b)> listeners(count, b);
+
+            dispatcher d;
+            for (const auto& listener : listeners) {
+                d += listener;
+            }
+            report("kind", "bind", count, sizeof(small_signal), measure(iterations, [&d](std::size_t i) { d.dispatch(small_signal(i)); }), "ns/dispatch");
+        }
+
+        {
+            dispatcher d;
+            for (std::size_t i = 0; i < count; ++i) {
+                d.add(listener<small_signal>(&free_listener, i + 1));
+            }
+            report("kind", "free_function", count, sizeof(small_signal), measure(iterations, [&d](std::size_t i) { d.dispatch(small_signal(i)); }), "ns/dispatch");
+        }
+
+        {
+            std::vector<member_listener> objects(count, member_listener{ 1 });
+
+            dispatcher d;
+            for (member_listener& object : objects) {
+                d.add(listener<small_signal>(delegate<void(const small_signal&)>(&object, &member_listener::on_signal), reinterpret_cast<std::uintptr_t>(&object)));
+            }
+            report("kind", "member_function", count, sizeof(small_signal), measure(iterations, [&d](std::size_t i) { d.dispatch(small_signal(i)); }), "ns/dispatch");
+        }
+    }
+
+    /**
+     * <code>static_dispatcher</code> against <code>dispatcher</code> for the same lambda listeners.
+     */
+    void bench_static(std::size_t count) {
+        auto l = [](const small_signal& s) { g_sink += s.value; };
+        std::vector<decltype(l)> listeners(count, l);
+
+        static_dispatcher<small_signal> d;
+        for (const auto& listener : listeners) {
+            d += listener;
+        }
+
+        double ns = measure(iterations_for(count), [&d](std::size_t i) { d.dispatch(small_signal(i)); });
+        report("static", "latency", count, sizeof(small_signal), ns, "ns/dispatch");
+    }
+
+    /**
+     * An event against a signal carrying the same value, with <code>count</code> listeners.
+     */
+    void bench_event(std::size_t count) {
+        auto l = [](std::uint64_t value) { g_sink += value; };
+        std::vector<decltype(l)> listeners(count, l);
+
+        dispatcher d;
+        for (const auto& listener : listeners) {
+            d.add<value_event>(listener);
+        }
+
+        double ns = measure(iterations_for(count), [&d](std::size_t i) { d.dispatch<value_event>(i); });
+        report("event", "latency", count, sizeof(std::uint64_t), ns, "ns/dispatch");
+    }
+
+    /**
+     * Cost of subscribing and unsubscribing while a list already holds <code>count</code> listeners.
+     */
+    void bench_churn(std::size_t count) {
+        auto l = [](const small_signal& s) { g_sink += s.value; };
+        std::vector<decltype(l)> listeners(count + 1, l);
+
+        dispatcher d;
+        for (std::size_t i = 0; i < count; ++i) {
+            d += listeners[i];
+        }
+
+        const decltype(l)& churned = listeners[count];
+        const std::size_t iterations = 200000;
+
+        report("churn", "address", count, 0, measure(iterations, [&d, &churned](std::size_t) { 
+            d += churned; 
+            d -= churned; 
+        }), "ns/add+remove");
+
+        report("churn", "handle", count, 0, measure(iterations, [&d, &churned](std::size_t) { 
+            subscription s = d += churned; 
+            d.remove(s); 
+        }), "ns/add+remove");
+    }
+
+    /**
+     * One listener per entity, delivering to a single entity: listeners filtering on the entity themselves 
+     * against keyed listeners.
+     */
+    void bench_keyed(std::size_t count) {
+        std::vector<std::uint32_t> entities(count);
+        const std::size_t iterations = iterations_for(count);
+
+        {
+            dispatcher d;
+            for (std::uint32_t i = 0; i < count; ++i) {
+                entities[i] = i;
+                const std::uint32_t* mine = &entities[i];
+                d.add(listener<entity_signal>([mine](const entity_signal& s) { 
+                    if (s.entity == *mine) {
+                        g_sink += s.entity;
+                    }
+                }, i + 1));
+            }
+            report("keyed", "filtered", count, sizeof(entity_signal), measure(iterations, [&d, count](std::size_t i) { 
+                d.dispatch(entity_signal(static_cast<std::uint32_t>(i % count))); 
+            }), "ns/dispatch");
+        }
+
+        {
+            dispatcher d;
+            for (std::uint32_t i = 0; i < count; ++i) {
+                d.add_keyed<entity_signal>(i, listener<entity_signal>([](const entity_signal& s) { g_sink += s.entity; }, i + 1));
+            }
+            report("keyed", "keyed", count, sizeof(entity_signal), measure(iterations, [&d, count](std::size_t i) { 
+                d.dispatch(entity_signal(static_cast<std::uint32_t>(i % count))); 
+            }), "ns/dispatch");
+        }
+    }
+
+    /**
+     * Heap bytes per subscription, measured over <code>count</code> subscriptions.
+     */
+    void bench_memory(std::size_t count) {
+        report("memory", "dispatcher", 0, 0, sizeof(dispatcher), "bytes");
+
+        auto l = [](const small_signal& s) { g_sink += s.value; };
+        std::vector<decltype(l)> listeners(count, l);
+
+        dispatcher d;
+        d.dispatch(small_signal(0));
+
+        std::size_t before = g_allocated_bytes;
+        std::size_t allocations = g_allocations;
+        for (const auto& listener : listeners) {
+            d += listener;
+        }
+
+        report("memory", "subscription", count, 0, double(g_allocated_bytes - before) / count, "bytes");
+        report("memory", "allocations", count, 0, double(g_allocations - allocations) / count, "allocations/subscription");
+        report("memory", "reported", count, 0, d.memory_usage().per_subscription(), "bytes/subscription");
+    }
+
+};
+
+int main() {
+    std::printf("benchmark,variant,listeners,payload_bytes,value,unit\n");
+
+#ifdef DISPATCH_INSTRUMENTATION
+    report("build", "instrumentation", 0, 0, 1, "enabled");
+#else
+    report("build", "instrumentation", 0, 0, 0, "enabled");
+#endif
+
+    bench_fanout();
+
+    bench_payload<8>(10);
+    bench_payload<64>(10);
+    bench_payload<256>(10);
+    bench_payload<1024>(10);
+
+    bench_listener_kinds();
+
+    bench_static(1);
+    bench_static(10);
+    bench_static(1000);
+
+    bench_event(1);
+    bench_event(10);
+    bench_event(1000);
+
+    bench_churn(10);
+    bench_churn(1000);
+
+    bench_keyed(10);
+    bench_keyed(1000);
+
+    bench_memory(1000);
+
+    return g_sink == 42 ? 1 : 0;
+}
@@ -0,0 +1,108 @@
+////////////////////////////////////////////////////////////////////////////////
+//
+// The MIT License (MIT)
+// 
+// Copyright (c) 2015 Matt Bolt
+// 
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+// 
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+// 
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+////////////////////////////////////////////////////////////////////////////////
+
+// Measures sequential vs. parallel fan-out over a range of listener counts and per-listener costs, to find the
+// point where dispatcher::set_parallel starts paying for itself. Prints CSV:
+//
+//     listeners,work,sequential_ns,parallel_ns,speedup
+
+#include <chrono>
+#include <cstdio>
+#include <cstdint>
+#include <vector>
+#include "dispatcher.h"
+
+using namespace dispatch;
+
+namespace {
+
+    struct work_signal : public signal {
+        std::uint64_t seed;
+        work_signal(std::uint64_t _seed) : signal(), seed(_seed) { }
+    };
+
+    /**
+     * Burns roughly <code>iterations</code> multiply-adds so listeners have a tunable cost.
+     */
+    struct busy_listener {
+        std::size_t iterations;
+        std::uint64_t* sink;
+
+        void operator()(const work_signal& s) const {
+            std::uint64_t x = s.seed;
+            for (std::size_t i = 0; i < iterations; ++i) {
+                x = x * 6364136223846793005ULL + 1442695040888963407ULL;
+            }
+            *sink = x;
+        }
+    };
+
+    double time_dispatch(dispatcher& d, std::size_t rounds) {
+        auto start = std::chrono::steady_clock::now();
+        for (std::size_t i = 0; i < rounds; ++i) {
+            d.dispatch(work_signal(i));
+        }
+        auto elapsed = std::chrono::steady_clock::now() - start;
+
+        return std::chrono::duration<double, std::nano>(elapsed).count() / rounds;
+    }
+
+};
+
+int main() {
+    const std::size_t listener_counts[] = { 1, 2, 4, 8, 16, 32, 64, 128, 256, 1024 };
+    const std::size_t work_sizes[] = { 10, 100, 1000, 10000 };
+
+    std::printf("listeners,work,sequential_ns,parallel_ns,speedup\n");
+
+    for (std::size_t work : work_sizes) {
+        for (std::size_t count : listener_counts) {
+            std::vector<std::uint64_t> sinks(count * 8);
+            std::vector<busy_listener> listeners;
+            listeners.reserve(count);
+
+            dispatcher d;
+            for (std::size_t i = 0; i < count; ++i) {
+                listeners.push_back(busy_listener{ work, &sinks[i * 8] });
+                d += listeners.back();
+            }
+
+            std::size_t rounds = std::max<std::size_t>(10, 2000000 / (count * work));
+
+            d.set_sequential<work_signal>();
+            time_dispatch(d, rounds / 10 + 1);
+            double sequential = time_dispatch(d, rounds);
+
+            d.set_parallel<work_signal>(1);
+            time_dispatch(d, rounds / 10 + 1);
+            double parallel = time_dispatch(d, rounds);
+
+            std::printf("%zu,%zu,%.1f,%.1f,%.2f\n", count, work, sequential, parallel, sequential / parallel);
+        }
+    }
+
+    return 0;
+}
@@ -0,0 +1,126 @@
+////////////////////////////////////////////////////////////////////////////////
+//
+// The MIT License (MIT)
+// 
+// Copyright (c) 2015 Matt Bolt
+// 
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+// 
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+// 
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+////////////////////////////////////////////////////////////////////////////////
+
+// Recording and replay throughput: a tap records every dispatch of two signal types to a log in the temporary
+// directory, then the log is replayed as fast as possible into a dispatcher with one listener per type. Prints CSV:
+//
+//     benchmark,variant,records,bytes,value,unit
+
+#include <chrono>
+#include <cstdio>
+#include <cstdint>
+#include <cstdlib>
+#include <string>
+#include "recording.h"
+
+using namespace dispatch;
+
+struct position {
+    float x;
+    float y;
+};
+
+struct move_signal : public signal {
+    position to;
+
+    move_signal(const position& _to) : signal(), to(_to) { }
+};
+
+struct damage {
+    std::uint32_t entity;
+    std::uint32_t amount;
+};
+
+struct damage_signal : public signal {
+    damage hit;
+
+    damage_signal(const damage& _hit) : signal(), hit(_hit) { }
+};
+
+DISPATCH_SIGNAL_RECORD(move_signal, 1, to)
+DISPATCH_SIGNAL_RECORD(damage_signal, 2, hit)
+
+namespace {
+
+    const std::size_t signals = 10000000;
+
+    std::uint64_t g_sink = 0;
+
+    double seconds_since(std::chrono::steady_clock::time_point start) {
+        return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    }
+
+};
+
+int main() {
+    const char* tmp = std::getenv("TMPDIR");
+    const std::string path = std::string(tmp ? tmp : "/tmp") + "/dispatch_replay_bench.log";
+
+    std::printf("benchmark,variant,records,bytes,value,unit\n");
+
+    std::size_t records = 0;
+    std::size_t bytes = 0;
+    {
+        dispatcher d;
+        signal_recorder recorder(path);
+        recorder.record<move_signal>(d);
+        recorder.record<damage_signal>(d);
+
+        auto start = std::chrono::steady_clock::now();
+        for (std::size_t i = 0; i < signals; ++i) {
+            if (i % 8 == 0) {
+                d.dispatch(damage_signal(damage{ static_cast<std::uint32_t>(i), 1 }));
+            } else {
+                d.dispatch(move_signal(position{ float(i), float(i) }));
+            }
+        }
+        double seconds = seconds_since(start);
+
+        records = recorder.records();
+        bytes = recorder.bytes();
+        std::printf("record,tap,%zu,%zu,%.0f,signals/s\n", records, bytes, records / seconds);
+    }
+
+    {
+        signal_replayer replayer(path);
+        replayer.bind<move_signal>();
+        replayer.bind<damage_signal>();
+
+        dispatcher d;
+        d += [](const move_signal& s) { g_sink += static_cast<std::uint64_t>(s.to.x); };
+        d += [](const damage_signal& s) { g_sink += s.hit.amount; };
+
+        auto start = std::chrono::steady_clock::now();
+        std::size_t replayed = replayer.replay(d);
+        double seconds = seconds_since(start);
+
+        std::printf("replay,fastest,%zu,%zu,%.0f,signals/s\n", replayed, bytes, replayed / seconds);
+    }
+
+    std::remove(path.c_str());
+
+    return g_sink == 42 ? 1 : 0;
+}
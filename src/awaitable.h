@@ -0,0 +1,265 @@
+////////////////////////////////////////////////////////////////////////////////
+//
+// The MIT License (MIT)
+// 
+// Copyright (c) 2015 Matt Bolt
+// 
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+// 
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+// 
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+////////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include "dispatcher.h"
+
+// Coroutine support needs C++20, unlike the rest of the library. DISPATCH_COROUTINES is defined when this header 
+// provides it, so code shared with older builds can test for it.
+#if defined(__cpp_impl_coroutine) && defined(__has_include)
+#if __has_include(<coroutine>)
+#define DISPATCH_COROUTINES 1
+#endif
+#endif
+
+#ifdef DISPATCH_COROUTINES
+
+#include <coroutine>
+#include <cstdint>
+
+
+namespace dispatch {
+
+    /**
+     * The awaitable returned by <code>dispatcher::next</code>. It lives in the awaiting coroutine's frame, and
+     * subscribes itself for one signal while the coroutine is suspended, so waiting allocates nothing once the
+     * listener list has room. The coroutine is resumed from inside the dispatch, and the signal it receives is
+     * only valid until it next suspends. Destroying a suspended coroutine cancels the wait. The dispatcher 
+     * must outlive it.
+     *
+     * The awaiter always waits for a dispatch. A sticky type's latest value, which <code>add</code> replays,
+     * is ignored, or every await in a loop would get the same value back without suspending. Read it with 
+     * <code>dispatcher::latest</code>, or wait on a <code>signal_stream</code>.
+     */
+    template<class T>
+    class signal_awaiter {
+        public:
+            //----------------------------------
+            //  constructor
+            //----------------------------------
+
+            signal_awaiter(dispatcher& _dispatcher, int _priority)
+                : m_dispatcher(_dispatcher),
+                  m_priority(_priority),
+                  m_value(nullptr),
+                  m_subscribing(false)
+            { }
+
+            signal_awaiter(const signal_awaiter&) = delete;
+            signal_awaiter& operator=(const signal_awaiter&) = delete;
+
+            //----------------------------------
+            //  destructor
+            //----------------------------------
+
+            ~signal_awaiter() {
+                if (m_subscription) {
+                    m_dispatcher.remove(m_subscription);
+                }
+            }
+
+            //----------------------------------
+            //  methods
+            //----------------------------------
+
+            bool await_ready() const noexcept {
+                return false;
+            }
+
+            /**
+             * Subscribes for the next signal.
+             */
+            void await_suspend(std::coroutine_handle<> handle) {
+                m_handle = handle;
+
+                m_subscribing = true;
+                m_subscription = m_dispatcher.add(listener<T>(delegate<void(const T&)>(this, &signal_awaiter::fire), 
+                    reinterpret_cast<std::uintptr_t>(this)), m_priority);
+                m_subscribing = false;
+            }
+
+            const T& await_resume() const noexcept {
+                return *m_value;
+            }
+
+        private:
+            dispatcher& m_dispatcher;
+            int m_priority;
+            const T* m_value;
+            bool m_subscribing;
+            subscription m_subscription;
+            std::coroutine_handle<> m_handle;
+
+            void fire(const T& value) {
+                // A sticky replay from add, not a dispatch.
+                if (m_subscribing) {
+                    return;
+                }
+
+                m_value = &value;
+                m_dispatcher.remove(m_subscription);
+                m_subscription = subscription();
+                m_handle.resume();
+            }
+    };
+
+    /**
+     * The stream returned by <code>dispatcher::stream</code>. It holds one subscription for its whole life, 
+     * and <code>co_await stream.next()</code> resumes the coroutine with the next signal from inside the 
+     * dispatch. Only one coroutine may wait on a stream at a time. Signals dispatched while nothing is waiting 
+     * are not buffered, and are counted by <code>missed</code>.
+     *
+     * For a sticky type, the first <code>next</code> returns the latest value right away if nothing has been 
+     * dispatched since the stream subscribed. Every later one waits for a dispatch.
+     */
+    template<class T>
+    class signal_stream {
+        public:
+            /**
+             * The awaitable returned by <code>next</code>.
+             */
+            class awaiter {
+                public:
+                    explicit awaiter(signal_stream& _stream) : m_stream(_stream) { }
+
+                    bool await_ready() noexcept {
+                        return m_stream.take_replayed();
+                    }
+
+                    void await_suspend(std::coroutine_handle<> handle) noexcept {
+                        m_stream.m_waiting = handle;
+                    }
+
+                    const T& await_resume() const noexcept {
+                        return *m_stream.m_value;
+                    }
+
+                private:
+                    signal_stream& m_stream;
+            };
+
+            //----------------------------------
+            //  constructor
+            //----------------------------------
+
+            signal_stream(dispatcher& _dispatcher, int _priority)
+                : m_dispatcher(_dispatcher),
+                  m_value(nullptr),
+                  m_missed(0),
+                  m_subscribing(true),
+                  m_replayed(false)
+            { 
+                m_subscription = m_dispatcher.add(listener<T>(delegate<void(const T&)>(this, &signal_stream::fire), 
+                    reinterpret_cast<std::uintptr_t>(this)), _priority);
+                m_subscribing = false;
+            }
+
+            signal_stream(const signal_stream&) = delete;
+            signal_stream& operator=(const signal_stream&) = delete;
+
+            //----------------------------------
+            //  destructor
+            //----------------------------------
+
+            ~signal_stream() {
+                m_dispatcher.remove(m_subscription);
+            }
+
+            //----------------------------------
+            //  methods
+            //----------------------------------
+
+            awaiter next() {
+                return awaiter(*this);
+            }
+
+            /**
+             * The number of signals dispatched while no coroutine was waiting.
+             */
+            std::size_t missed() const {
+                return m_missed;
+            }
+
+        private:
+            dispatcher& m_dispatcher;
+            subscription m_subscription;
+            const T* m_value;
+            std::size_t m_missed;
+            bool m_subscribing;
+            bool m_replayed;
+            std::coroutine_handle<> m_waiting;
+
+            void fire(const T& value) {
+                // The sticky value replayed by add. It's looked up again by the first await, as it may have 
+                // been cleared by then.
+                if (m_subscribing) {
+                    m_replayed = true;
+                    return;
+                }
+
+                // A dispatch supersedes the replayed value, whether or not anyone was waiting for it.
+                m_replayed = false;
+
+                if (!m_waiting) {
+                    ++m_missed;
+                    return;
+                }
+
+                std::coroutine_handle<> handle = m_waiting;
+                m_waiting = nullptr;
+                m_value = &value;
+                handle.resume();
+            }
+
+            /**
+             * Hands the replayed sticky value to the first await, if it's still the latest.
+             */
+            bool take_replayed() {
+                if (!m_replayed) {
+                    return false;
+                }
+
+                m_replayed = false;
+                m_value = m_dispatcher.latest<T>();
+
+                return m_value != nullptr;
+            }
+    };
+
+    template<class T>
+    signal_awaiter<T> dispatcher::next(int priority) {
+        return signal_awaiter<T>(*this, priority);
+    }
+
+    template<class T>
+    signal_stream<T> dispatcher::stream(int priority) {
+        return signal_stream<T>(*this, priority);
+    }
+
+};
+
+#endif
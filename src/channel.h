@@ -0,0 +1,194 @@
+////////////////////////////////////////////////////////////////////////////////
+//
+// The MIT License (MIT)
+// 
+// Copyright (c) 2015 Matt Bolt
+// 
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+// 
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+// 
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+////////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <stdexcept>
+#include <thread>
+#include <type_traits>
+#include <vector>
+#include "ring_buffer.h"
+#include "dispatcher.h"
+
+
+namespace dispatch {
+
+    /**
+     * Forwards signals of <code>T</code> from one or more source dispatchers to a target dispatcher on another
+     * thread. The channel listens for <code>T</code> on each source and copies every dispatched signal into a 
+     * bounded lock-free ring (<code>Ring</code>). The target's thread calls <code>pump</code> from its own loop,
+     * which drains everything queued and delivers it with a single <code>dispatch_batch</code> per contiguous
+     * run, straight out of the ring. Signals from one source arrive in the order they were dispatched.
+     *
+     * Signals are copied as <code>T</code>, so a derived signal routed to a <code>T</code> listener on the 
+     * source arrives as a plain <code>T</code>. When the ring is full, <code>overflow_policy::block</code> 
+     * makes the producer yield until the target catches up (the source and target must then be on different 
+     * threads) and <code>overflow_policy::drop_newest</code> discards the signal. Only the consumer may remove 
+     * from the ring, so <code>overflow_policy::drop_oldest</code> isn't supported.
+     *
+     * Sources must outlive the channel. Connect them, and destroy the channel, while they aren't dispatching.
+     */
+    template<class T, class Ring>
+    class basic_channel {
+        public:
+            //----------------------------------
+            //  constructor
+            //----------------------------------
+
+            basic_channel(dispatcher& target, std::size_t capacity, overflow_policy policy = overflow_policy::block)
+                : m_target(target),
+                  m_queue(capacity),
+                  m_policy(policy),
+                  m_dropped(0)
+            { 
+                if (policy == overflow_policy::drop_oldest) {
+                    throw std::invalid_argument("dispatch::channel: drop_oldest is not supported");
+                }
+            }
+
+            basic_channel(dispatcher& source, dispatcher& target, std::size_t capacity, overflow_policy policy = overflow_policy::block)
+                : basic_channel(target, capacity, policy)
+            { 
+                connect(source);
+            }
+
+            basic_channel(const basic_channel&) = delete;
+            basic_channel& operator=(const basic_channel&) = delete;
+
+            //----------------------------------
+            //  destructor
+            //----------------------------------
+
+            /**
+             * Disconnects from every source. Signals still queued are dropped.
+             */
+            ~basic_channel() {
+                for (const source& s : m_sources) {
+                    s.dispatcher->remove(s.handle);
+                }
+            }
+
+            //----------------------------------
+            //  methods
+            //----------------------------------
+
+            /**
+             * Forwards every <code>T</code> dispatched on <code>from</code> from now on. A single producer ring 
+             * can only have one source.
+             */
+            subscription connect(dispatcher& from) {
+                if (!Ring::multi_producer && !m_sources.empty()) {
+                    throw std::logic_error("dispatch::channel: a single producer channel can only have one source");
+                }
+
+                subscription handle = from.add(listener<T>(
+                    [this](const T& value) { send(value); }, 
+                    reinterpret_cast<std::uintptr_t>(this)));
+                m_sources.push_back(source{ &from, handle });
+
+                return handle;
+            }
+
+            /**
+             * Queues a copy of <code>value</code> directly, from a producer thread. Returns false if it was
+             * dropped.
+             */
+            bool send(const T& value) {
+                while (!m_queue.try_emplace(value)) {
+                    if (m_policy == overflow_policy::drop_newest) {
+                        m_dropped.fetch_add(1, std::memory_order_relaxed);
+                        return false;
+                    }
+
+                    std::this_thread::yield();
+                }
+
+                return true;
+            }
+
+            /**
+             * Delivers up to <code>max</code> queued signals through the target, on the calling thread, and 
+             * returns how many were delivered. Only the target's thread may pump.
+             */
+            std::size_t pump(std::size_t max = std::numeric_limits<std::size_t>::max()) {
+                dispatcher& target = m_target;
+                return m_queue.consume([&target](const T* values, std::size_t count) { 
+                    target.dispatch_batch(values, count); 
+                }, max);
+            }
+
+            /**
+             * The number of signals discarded under <code>overflow_policy::drop_newest</code>.
+             */
+            std::size_t dropped() const {
+                return m_dropped.load(std::memory_order_relaxed);
+            }
+
+            /**
+             * An approximate count of queued signals.
+             */
+            std::size_t size() const {
+                return m_queue.size();
+            }
+
+            std::size_t capacity() const {
+                return m_queue.capacity();
+            }
+
+            dispatcher& target() {
+                return m_target;
+            }
+
+        private:
+            struct source {
+                dispatch::dispatcher* dispatcher;
+                subscription handle;
+            };
+
+            dispatcher& m_target;
+            Ring m_queue;
+            overflow_policy m_policy;
+            std::atomic<std::size_t> m_dropped;
+            std::vector<source> m_sources;
+    };
+
+    /**
+     * A channel with a single source dispatcher (one producer thread).
+     */
+    template<class T>
+    using spsc_channel = basic_channel<T, spsc_ring<T>>;
+
+    /**
+     * A channel which any number of source dispatchers, on any threads, may feed.
+     */
+    template<class T>
+    using mpsc_channel = basic_channel<T, mpsc_ring<T>>;
+
+};
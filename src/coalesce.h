@@ -0,0 +1,171 @@
+////////////////////////////////////////////////////////////////////////////////
+//
+// The MIT License (MIT)
+// 
+// Copyright (c) 2015 Matt Bolt
+// 
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+// 
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+// 
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+////////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include <cstddef>
+#include <new>
+#include <type_traits>
+#include <utility>
+#include "delegate.h"
+
+
+namespace dispatch {
+
+    class dispatcher;
+
+    /**
+     * A coalesced signal type's pending value. See <code>coalesced_value</code>.
+     */
+    class coalesced_value_base {
+        public:
+            typedef std::size_t (*flush_t)(dispatcher&, std::size_t id);
+
+            explicit coalesced_value_base(flush_t _flush) 
+                : m_events(0),
+                  m_flush(_flush) 
+            { }
+
+            virtual ~coalesced_value_base() { }
+
+            /**
+             * Delivers the pending value of signal id <code>id</code> through <code>d</code>, if there is one, and
+             * returns the number of events it stood for.
+             */
+            std::size_t flush(dispatcher& d, std::size_t id) {
+                return m_flush(d, id);
+            }
+
+            /**
+             * Merges <code>value</code>, which points to the concrete signal, into the pending value. Returns 
+             * true if it's the first event since the last flush.
+             */
+            virtual bool absorb(const void* value) = 0;
+
+            /**
+             * The bytes allocated for this object.
+             */
+            virtual std::size_t memory_usage() const = 0;
+
+            /**
+             * The number of events merged into the pending value.
+             */
+            std::size_t events() const {
+                return m_events;
+            }
+
+        protected:
+            std::size_t m_events;
+
+        private:
+            flush_t m_flush;
+    };
+
+    /**
+     * Collects dispatches of <code>T</code> between flushes. The first event is copied in place and later ones
+     * are merged into it, either by replacing it (the latest value wins) or through a reducer.
+     */
+    template<class T>
+    class coalesced_value : public coalesced_value_base {
+        public:
+            typedef delegate<void(T&, const T&)> reducer_t;
+
+            //----------------------------------
+            //  constructor
+            //----------------------------------
+
+            coalesced_value(flush_t _flush, reducer_t reducer) 
+                : coalesced_value_base(_flush), 
+                  m_reducer(std::move(reducer)) 
+            { }
+
+            coalesced_value(const coalesced_value&) = delete;
+            coalesced_value& operator=(const coalesced_value&) = delete;
+
+            //----------------------------------
+            //  destructor
+            //----------------------------------
+
+            ~coalesced_value() {
+                if (m_events > 0) {
+                    pending().~T();
+                }
+            }
+
+            //----------------------------------
+            //  methods
+            //----------------------------------
+
+            std::size_t memory_usage() const override {
+                return sizeof(*this);
+            }
+
+            bool absorb(const void* value) override {
+                const T& next = *static_cast<const T*>(value);
+
+                if (m_events++ == 0) {
+                    ::new (static_cast<void*>(&m_storage)) T(next);
+                    return true;
+                }
+
+                if (m_reducer) {
+                    m_reducer(pending(), next);
+                } else {
+                    pending() = next;
+                }
+
+                return false;
+            }
+
+            /**
+             * Moves the pending value out, resets, then hands the value to <code>deliver</code>. Returns the number
+             * of events it stood for, or 0 if nothing was pending.
+             */
+            template<class F>
+            std::size_t take(F&& deliver) {
+                std::size_t events = m_events;
+                if (events == 0) {
+                    return 0;
+                }
+
+                T value(std::move(pending()));
+                pending().~T();
+                m_events = 0;
+
+                deliver(value);
+                return events;
+            }
+
+        private:
+            typename std::aligned_storage<sizeof(T), std::alignment_of<T>::value>::type m_storage;
+            reducer_t m_reducer;
+
+            T& pending() {
+                return *reinterpret_cast<T*>(&m_storage);
+            }
+    };
+
+};
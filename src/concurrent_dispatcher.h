@@ -0,0 +1,246 @@
+////////////////////////////////////////////////////////////////////////////////
+//
+// The MIT License (MIT)
+// 
+// Copyright (c) 2015 Matt Bolt
+// 
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+// 
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+// 
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+////////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include <vector>
+#include <memory>
+#include <mutex>
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <type_traits>
+#include "listener.h"
+#include "signal_id.h"
+#include "epoch.h"
+#include "dispatch_context.h"
+#include "helpers.h"
+
+
+namespace dispatch {
+
+    /**
+     * A thread safe variant of <code>dispatcher</code>. Dispatching takes no lock: each listener table is an 
+     * immutable snapshot which <code>+=</code> and <code>-=</code> replace wholesale (copy-on-write), and replaced
+     * snapshots are reclaimed through the global <code>epoch_domain</code> once no dispatch can still see them.
+     *
+     * A listener removed with <code>-=</code> is never invoked after <code>-=</code> returns. Removal marks the 
+     * listener inactive, then waits for dispatches already in flight on other threads to finish. Nested dispatches
+     * on the removing thread skip the listener via the inactive mark. The one exception is a thread that is itself 
+     * blocked in <code>-=</code> from inside a listener. It isn't waited on, and only the listener it's currently
+     * running can still be on its stack.
+     */
+    class concurrent_dispatcher {
+        public:
+            //----------------------------------
+            //  constructor
+            //----------------------------------
+
+            concurrent_dispatcher();
+
+            //----------------------------------
+            //  destructor
+            //----------------------------------
+
+            ~concurrent_dispatcher();
+
+            concurrent_dispatcher(const concurrent_dispatcher&) = delete;
+            concurrent_dispatcher& operator=(const concurrent_dispatcher&) = delete;
+
+            //----------------------------------
+            //  methods
+            //----------------------------------
+
+            template<class T>
+            void add(listener<T>* ptr) {
+                entry_t e = std::make_shared<entry>(ptr);
+                std::size_t id = signal_id<T>::value();
+
+                std::unique_lock<std::mutex> lock(m_write_lock);
+                snapshot* next = new snapshot(*m_snapshot.load(std::memory_order_relaxed));
+                if (id >= next->lists.size()) {
+                    next->lists.resize(id + 1);
+                }
+
+                list_t* list = next->lists[id] ? new list_t(*next->lists[id]) : new list_t();
+                list->push_back(e);
+                next->lists[id].reset(list);
+
+                publish(next, lock);
+            }
+
+            template<class E>
+            void remove(const E& dispatchListener) {
+                typedef typename std::decay<function_param_at<function_type_for_t<E>, 0>>::type T;
+
+                std::uintptr_t addr = pointer_memory<E>::address_for(dispatchListener);
+                std::size_t id = signal_id<T>::value();
+
+                std::unique_lock<std::mutex> lock(m_write_lock);
+                const snapshot* current = m_snapshot.load(std::memory_order_relaxed);
+                if (id >= current->lists.size() || !current->lists[id]) {
+                    return;
+                }
+
+                const list_t& v = *current->lists[id];
+                auto result = std::find_if(v.begin(), v.end(), [&addr](const entry_t& check) {
+                    return *static_cast<const listener<T>*>(check->target.get()) == addr;
+                });
+
+                if (result == v.end()) {
+                    return;
+                }
+
+                (*result)->active.store(false);
+
+                snapshot* next = new snapshot(*current);
+                list_t* list = new list_t();
+                list->reserve(v.size() - 1);
+                for (auto it = v.begin(); it != v.end(); ++it) {
+                    if (it != result) {
+                        list->push_back(*it);
+                    }
+                }
+                next->lists[id].reset(list);
+
+                publish(next, lock);
+            }
+
+            template<class T>
+            inline concurrent_dispatcher& operator+=(const T& dispatchListener) {
+                wrap_add(
+                    function_wrapper<T>::wrap(dispatchListener),
+                    pointer_memory<T>::address_for(dispatchListener));
+
+                return *this;
+            }
+
+            template<class T>
+            inline concurrent_dispatcher& operator-=(const T& dispatchListener) {
+                remove<T>(dispatchListener);
+
+                return *this;
+            }
+
+            /**
+             * Delivers <code>value</code> to every listener of <code>T</code> in the current snapshot. This never 
+             * blocks and never writes to memory shared with other dispatching threads.
+             */
+            template<class T> 
+            void dispatch(const T& value) const {
+                static_assert(std::is_base_of<signal, T>::value, "T type must implement signal.");
+
+                epoch_domain::guard reading;
+
+                // Listeners can't consume here, the frame only keeps consume() from reaching an outer dispatch.
+                dispatch_context frame;
+
+                const snapshot* current = m_snapshot.load();
+                std::size_t id = signal_id<T>::value();
+                if (id >= current->lists.size() || !current->lists[id]) {
+                    return;
+                }
+
+                for (const entry_t& e : *current->lists[id]) {
+                    if (e->active.load(std::memory_order_acquire)) {
+                        (*static_cast<const listener<T>*>(e->target.get()))(value);
+                    }
+                }
+            }
+
+        private:
+            /**
+             * Listeners are shared between consecutive snapshots, so removal can flag the listener itself.
+             */
+            struct entry {
+                std::unique_ptr<handler> target;
+                std::atomic<bool> active;
+
+                explicit entry(handler* h) : target(h), active(true) { }
+            };
+
+            typedef std::shared_ptr<entry> entry_t;
+            typedef std::vector<entry_t> list_t;
+
+            /**
+             * An immutable listener table indexed by <code>signal_id</code>. Lists that didn't change are shared
+             * with the previous snapshot.
+             */
+            struct snapshot {
+                std::vector<std::shared_ptr<const list_t>> lists;
+            };
+
+            struct retired {
+                const snapshot* table;
+                std::uint64_t epoch;
+            };
+
+            std::atomic<const snapshot*> m_snapshot;
+            std::mutex m_write_lock;
+            std::vector<retired> m_retired;
+
+            template<class T>
+            void wrap_add(const T& dispatchListener, std::uintptr_t addr) {
+                typedef typename std::decay<function_param_at<T, 0>>::type E;
+                add(new listener<E>(dispatchListener, addr));
+            }
+
+            /**
+             * Swaps in <code>next</code>, releases the write lock, waits out in-flight dispatches, then frees 
+             * any snapshots nobody can be reading anymore.
+             */
+            void publish(const snapshot* next, std::unique_lock<std::mutex>& lock) {
+                const snapshot* previous = m_snapshot.exchange(next);
+                lock.unlock();
+
+                std::uint64_t epoch = epoch_domain::global().synchronize();
+
+                lock.lock();
+                m_retired.push_back(retired{ previous, epoch });
+
+                auto it = std::remove_if(m_retired.begin(), m_retired.end(), [](const retired& r) {
+                    if (!epoch_domain::global().is_quiescent(r.epoch)) {
+                        return false;
+                    }
+
+                    delete r.table;
+                    return true;
+                });
+                m_retired.erase(it, m_retired.end());
+            }
+    };
+
+    inline concurrent_dispatcher::concurrent_dispatcher() 
+        : m_snapshot(new snapshot()) 
+    { }
+
+    inline concurrent_dispatcher::~concurrent_dispatcher() { 
+        delete m_snapshot.load();
+        for (const retired& r : m_retired) {
+            delete r.table;
+        }
+    }
+};
@@ -0,0 +1,434 @@
+////////////////////////////////////////////////////////////////////////////////
+//
+// The MIT License (MIT)
+// 
+// Copyright (c) 2015 Matt Bolt
+// 
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+// 
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+// 
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+////////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include <cstddef>
+#include <new>
+#include <exception>
+#include <memory>
+#include <utility>
+#include <type_traits>
+
+
+namespace dispatch {
+
+    template<class Sig> class unique_delegate;
+
+    /**
+     * Type erased, copyable storage for a delegate target. Targets of up to <code>inline_size</code> bytes 
+     * which can be moved without throwing are constructed in place, which covers free functions, member 
+     * function and object pairs, and lambdas capturing a few pointers. Anything larger goes to the heap.
+     *
+     * Copying, moving and destroying go through a single manager function. Invoking doesn't touch the 
+     * storage's bookkeeping at all, it's left to whoever knows the target type (see <code>delegate</code>).
+     *
+     * Targets must be copyable, which is checked when the storage is built. Move-only targets can only be 
+     * stored by a <code>unique_delegate</code>, which can't be copied itself.
+     */
+    class delegate_storage {
+        public:
+            static constexpr std::size_t inline_size = 4 * sizeof(void*);
+
+            /**
+             * Whether or not <code>F</code> is stored in place.
+             */
+            template<class F> struct is_inline 
+                : std::integral_constant<
+                    bool,
+                    sizeof(F) <= inline_size 
+                        && std::alignment_of<F>::value <= std::alignment_of<std::max_align_t>::value
+                        && std::is_nothrow_move_constructible<F>::value> { };
+
+            //----------------------------------
+            //  constructor
+            //----------------------------------
+
+            delegate_storage() noexcept : m_manager(nullptr) { }
+
+            template<class F, class = typename std::enable_if<!std::is_same<typename std::decay<F>::type, delegate_storage>::value>::type>
+            explicit delegate_storage(F&& target) 
+                : m_manager(&manage<typename std::decay<F>::type>) 
+            { 
+                static_assert(std::is_copy_constructible<typename std::decay<F>::type>::value, 
+                    "delegate: the target must be copyable. Use unique_delegate for move-only targets.");
+
+                construct(std::forward<F>(target), is_inline<typename std::decay<F>::type>());
+            }
+
+            delegate_storage(const delegate_storage& other) 
+                : m_manager(other.m_manager) 
+            {
+                if (m_manager) {
+                    m_manager(operation::copy, *this, const_cast<delegate_storage&>(other));
+                }
+            }
+
+            delegate_storage(delegate_storage&& other) noexcept 
+                : m_manager(other.m_manager) 
+            {
+                if (m_manager) {
+                    m_manager(operation::move, *this, other);
+                    other.m_manager = nullptr;
+                }
+            }
+
+            //----------------------------------
+            //  destructor
+            //----------------------------------
+
+            ~delegate_storage() { 
+                reset(); 
+            }
+
+            //----------------------------------
+            //  operators
+            //----------------------------------
+
+            delegate_storage& operator=(const delegate_storage& other) {
+                if (this != &other) {
+                    delegate_storage copy(other);
+                    *this = std::move(copy);
+                }
+
+                return *this;
+            }
+
+            delegate_storage& operator=(delegate_storage&& other) noexcept {
+                if (this != &other) {
+                    reset();
+                    if (other.m_manager) {
+                        m_manager = other.m_manager;
+                        m_manager(operation::move, *this, other);
+                        other.m_manager = nullptr;
+                    }
+                }
+
+                return *this;
+            }
+
+            //----------------------------------
+            //  methods
+            //----------------------------------
+
+            bool empty() const noexcept {
+                return m_manager == nullptr;
+            }
+
+            void reset() noexcept {
+                if (m_manager) {
+                    m_manager(operation::destroy, *this, *this);
+                    m_manager = nullptr;
+                }
+            }
+
+            /**
+             * The bytes allocated for a target too large to be stored in place, or zero.
+             */
+            std::size_t heap_bytes() const noexcept {
+                return m_manager ? m_manager(operation::measure, const_cast<delegate_storage&>(*this), const_cast<delegate_storage&>(*this)) : 0;
+            }
+
+            /**
+             * Returns the stored target. <code>F</code> must be the exact type the storage was built with.
+             */
+            template<class F>
+            F& target() const noexcept {
+                return locate<F>(is_inline<F>());
+            }
+
+        private:
+            template<class Sig> friend class unique_delegate;
+
+            enum class operation { copy, move, destroy, measure };
+
+            struct move_only_t { };
+
+            /**
+             * Accepts move-only targets. Only for <code>unique_delegate</code>, which never copies its storage.
+             */
+            template<class F>
+            delegate_storage(F&& target, move_only_t) 
+                : m_manager(&manage<typename std::decay<F>::type>) 
+            { 
+                construct(std::forward<F>(target), is_inline<typename std::decay<F>::type>());
+            }
+
+            /**
+             * Returns the heap bytes for <code>measure</code>, and zero otherwise.
+             */
+            typedef std::size_t (*manager_t)(operation, delegate_storage&, delegate_storage&);
+
+            union {
+                typename std::aligned_storage<inline_size, std::alignment_of<std::max_align_t>::value>::type m_buffer;
+                void* m_heap;
+            };
+
+            manager_t m_manager;
+
+            template<class F>
+            void construct(F&& target, std::true_type) {
+                ::new (static_cast<void*>(&m_buffer)) typename std::decay<F>::type(std::forward<F>(target));
+            }
+
+            template<class F>
+            void construct(F&& target, std::false_type) {
+                m_heap = new typename std::decay<F>::type(std::forward<F>(target));
+            }
+
+            template<class F>
+            F& locate(std::true_type) const noexcept {
+                return *reinterpret_cast<F*>(const_cast<void*>(static_cast<const void*>(&m_buffer)));
+            }
+
+            template<class F>
+            F& locate(std::false_type) const noexcept {
+                return *static_cast<F*>(m_heap);
+            }
+
+            template<class F>
+            static void copy_target(delegate_storage& dst, delegate_storage& src, std::true_type) {
+                dst.construct(static_cast<const F&>(src.target<F>()), is_inline<F>());
+            }
+
+            /**
+             * Unreachable: move-only targets only live in a <code>unique_delegate</code>, which can't be copied.
+             */
+            template<class F>
+            static void copy_target(delegate_storage&, delegate_storage&, std::false_type) {
+                std::terminate();
+            }
+
+            template<class F>
+            static std::size_t manage(operation op, delegate_storage& dst, delegate_storage& src) {
+                return manage<F>(op, dst, src, is_inline<F>());
+            }
+
+            template<class F>
+            static std::size_t manage(operation op, delegate_storage& dst, delegate_storage& src, std::true_type) {
+                switch (op) {
+                    case operation::copy:
+                        copy_target<F>(dst, src, std::is_copy_constructible<F>());
+                        break;
+                    case operation::move:
+                        ::new (static_cast<void*>(&dst.m_buffer)) F(std::move(src.target<F>()));
+                        src.target<F>().~F();
+                        break;
+                    case operation::destroy:
+                        dst.target<F>().~F();
+                        break;
+                    case operation::measure:
+                        break;
+                }
+
+                return 0;
+            }
+
+            template<class F>
+            static std::size_t manage(operation op, delegate_storage& dst, delegate_storage& src, std::false_type) {
+                switch (op) {
+                    case operation::copy:
+                        copy_target<F>(dst, src, std::is_copy_constructible<F>());
+                        break;
+                    case operation::move:
+                        dst.m_heap = src.m_heap;
+                        src.m_heap = nullptr;
+                        break;
+                    case operation::destroy:
+                        delete static_cast<F*>(dst.m_heap);
+                        break;
+                    case operation::measure:
+                        return sizeof(F);
+                }
+
+                return 0;
+            }
+    };
+
+    /**
+     * A member function bound to an object instance.
+     */
+    template<class C, class M> struct bound_method {
+        C* object;
+        M method;
+
+        template<class...Args>
+        auto operator()(Args&&...args) const -> decltype((object->*method)(std::forward<Args>(args)...)) {
+            return (object->*method)(std::forward<Args>(args)...);
+        }
+    };
+
+    template<class Sig> class delegate;
+
+    /**
+     * A non-allocating replacement for <code>std::function</code>. Lambdas, function pointers, 
+     * <code>std::bind</code> results and member function and object pairs are stored inline when small 
+     * (see <code>delegate_storage</code>), and invoking is a single call through a function pointer with
+     * no virtual dispatch.
+     */
+    template<class R, class...Args> 
+    class delegate<R(Args...)> {
+        public:
+            /**
+             * The type erased call. The target is recovered from the storage by the invoker itself.
+             */
+            typedef R (*invoker_t)(const delegate_storage&, Args...);
+
+            //----------------------------------
+            //  constructor
+            //----------------------------------
+
+            delegate() noexcept : m_invoker(nullptr) { }
+
+            delegate(std::nullptr_t) noexcept : m_invoker(nullptr) { }
+
+            template<class F, class = typename std::enable_if<!std::is_same<typename std::decay<F>::type, delegate>::value>::type>
+            delegate(F&& target)
+                : m_storage(std::forward<F>(target)),
+                  m_invoker(&invoke<typename std::decay<F>::type>)
+            { }
+
+            template<class C>
+            delegate(C* object, R (C::*method)(Args...))
+                : delegate(bound_method<C, R (C::*)(Args...)>{ object, method })
+            { }
+
+            template<class C>
+            delegate(const C* object, R (C::*method)(Args...) const)
+                : delegate(bound_method<const C, R (C::*)(Args...) const>{ object, method })
+            { }
+
+            //----------------------------------
+            //  operators
+            //----------------------------------
+
+            inline R operator()(Args...args) const {
+                return m_invoker(m_storage, std::forward<Args>(args)...);
+            }
+
+            explicit operator bool() const noexcept {
+                return m_invoker != nullptr;
+            }
+
+            //----------------------------------
+            //  methods
+            //----------------------------------
+
+            /**
+             * The function used to invoke the target stored in <code>storage()</code>.
+             */
+            invoker_t invoker() const noexcept {
+                return m_invoker;
+            }
+
+            const delegate_storage& storage() const noexcept {
+                return m_storage;
+            }
+
+            /**
+             * Moves the target storage out, leaving this delegate empty. Used by containers that keep 
+             * <code>invoker()</code> and the storage in separate arrays.
+             */
+            delegate_storage release() noexcept {
+                m_invoker = nullptr;
+                return std::move(m_storage);
+            }
+
+        private:
+            delegate_storage m_storage;
+            invoker_t m_invoker;
+
+            template<class F>
+            static R invoke(const delegate_storage& storage, Args...args) {
+                return storage.target<F>()(std::forward<Args>(args)...);
+            }
+    };
+
+    /**
+     * A move-only <code>delegate</code>, for targets which can't be copied, such as a queued work item that owns
+     * its payload. Stored and invoked the same way as <code>delegate</code>.
+     */
+    template<class R, class...Args> 
+    class unique_delegate<R(Args...)> {
+        public:
+            typedef R (*invoker_t)(const delegate_storage&, Args...);
+
+            //----------------------------------
+            //  constructor
+            //----------------------------------
+
+            unique_delegate() noexcept : m_invoker(nullptr) { }
+
+            template<class F, class = typename std::enable_if<!std::is_same<typename std::decay<F>::type, unique_delegate>::value>::type>
+            unique_delegate(F&& target)
+                : m_storage(std::forward<F>(target), delegate_storage::move_only_t()),
+                  m_invoker(&invoke<typename std::decay<F>::type>)
+            { }
+
+            unique_delegate(unique_delegate&& other) noexcept 
+                : m_storage(std::move(other.m_storage)), 
+                  m_invoker(other.m_invoker) 
+            { 
+                other.m_invoker = nullptr;
+            }
+
+            unique_delegate(const unique_delegate&) = delete;
+
+            //----------------------------------
+            //  operators
+            //----------------------------------
+
+            unique_delegate& operator=(unique_delegate&& other) noexcept {
+                if (this != &other) {
+                    m_storage = std::move(other.m_storage);
+                    m_invoker = other.m_invoker;
+                    other.m_invoker = nullptr;
+                }
+
+                return *this;
+            }
+
+            unique_delegate& operator=(const unique_delegate&) = delete;
+
+            inline R operator()(Args...args) const {
+                return m_invoker(m_storage, std::forward<Args>(args)...);
+            }
+
+            explicit operator bool() const noexcept {
+                return m_invoker != nullptr;
+            }
+
+        private:
+            delegate_storage m_storage;
+            invoker_t m_invoker;
+
+            template<class F>
+            static R invoke(const delegate_storage& storage, Args...args) {
+                return storage.target<F>()(std::forward<Args>(args)...);
+            }
+    };
+
+};
@@ -0,0 +1,206 @@
+////////////////////////////////////////////////////////////////////////////////
+//
+// The MIT License (MIT)
+// 
+// Copyright (c) 2015 Matt Bolt
+// 
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+// 
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+// 
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+////////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <memory>
+
+
+namespace dispatch {
+
+    /**
+     * The state of one dispatch: whether each signal it delivers has been consumed. Every dispatch opens one
+     * on its own stack, so the signal objects themselves are never written to, and the same object may be 
+     * dispatched from several threads, or again from one of its own listeners.
+     *
+     * Frames nest per thread. A listener reaches the innermost one, the dispatch that's calling it, through
+     * <code>current()</code>, or consumes its signal with <code>dispatch::consume()</code>:
+     *
+     *     d += with_priority(100, [](const key_signal& s) {
+     *         if (s.code == KEY_ESCAPE) {
+     *             consume();
+     *         }
+     *     });
+     *
+     * A batch dispatch keeps one flag per signal, and <code>select</code> points the frame at the signal 
+     * being delivered. Batches of up to <code>inline_signals</code> keep their flags in the frame; larger ones 
+     * borrow a buffer kept per thread, so dispatching doesn't allocate once it has grown.
+     */
+    class dispatch_context {
+        public:
+            static const std::size_t inline_signals = 32;
+
+            //----------------------------------
+            //  constructor
+            //----------------------------------
+
+            /**
+             * Opens a frame for <code>count</code> signals, none of them consumed, and makes it the calling 
+             * thread's current frame until it's destroyed.
+             */
+            explicit dispatch_context(std::size_t count = 1) 
+                : m_consumed(false),
+                  m_borrowed(false),
+                  m_index(0), 
+                  m_flags(m_inline), 
+                  m_outer(top()) 
+            {
+                if (count > inline_signals) {
+                    m_flags = borrow(count);
+                }
+
+                if (count > 1) {
+                    std::fill(m_flags, m_flags + count, false);
+                }
+
+                top() = this;
+            }
+
+            dispatch_context(const dispatch_context&) = delete;
+            dispatch_context& operator=(const dispatch_context&) = delete;
+
+            //----------------------------------
+            //  destructor
+            //----------------------------------
+
+            ~dispatch_context() {
+                top() = m_outer;
+
+                if (m_borrowed) {
+                    spare().busy = false;
+                }
+            }
+
+            //----------------------------------
+            //  methods
+            //----------------------------------
+
+            /**
+             * The innermost dispatch running on the calling thread, or <code>nullptr</code> outside of one.
+             */
+            static dispatch_context* current() {
+                return top();
+            }
+
+            /**
+             * Stops the signal being delivered from reaching the listeners after the current one. Listeners run
+             * from highest to lowest priority, so a high priority listener can handle a signal before the rest 
+             * see it.
+             */
+            void consume() {
+                m_consumed = true;
+            }
+
+            bool consumed() const {
+                return m_consumed;
+            }
+
+            /**
+             * Whether the signal at <code>index</code> of the batch has been consumed.
+             */
+            bool consumed(std::size_t index) const {
+                return index == m_index ? m_consumed : m_flags[index];
+            }
+
+            /**
+             * Points the frame at the signal at <code>index</code> of the batch. Called by the dispatch loops
+             * before each delivery.
+             */
+            void select(std::size_t index) {
+                if (index != m_index) {
+                    m_flags[m_index] = m_consumed;
+                    m_consumed = m_flags[index];
+                    m_index = index;
+                }
+            }
+
+        private:
+            /**
+             * Flags for large batches. Only the outermost large batch on a thread borrows it; nested ones 
+             * allocate their own.
+             */
+            struct spare_flags {
+                std::unique_ptr<bool[]> flags;
+                std::size_t capacity;
+                bool busy;
+
+                spare_flags() : capacity(0), busy(false) { }
+            };
+
+            /**
+             * The selected signal's flag is kept apart from the rest, so checking it after each listener is a
+             * single load. The others are in <code>m_flags</code>.
+             */
+            bool m_consumed;
+            bool m_borrowed;
+            std::size_t m_index;
+            bool* m_flags;
+            dispatch_context* m_outer;
+            std::unique_ptr<bool[]> m_owned;
+            bool m_inline[inline_signals];
+
+            static dispatch_context*& top() {
+                static thread_local dispatch_context* frame = nullptr;
+                return frame;
+            }
+
+            static spare_flags& spare() {
+                static thread_local spare_flags buffer;
+                return buffer;
+            }
+
+            bool* borrow(std::size_t count) {
+                spare_flags& buffer = spare();
+                if (buffer.busy) {
+                    m_owned.reset(new bool[count]);
+                    return m_owned.get();
+                }
+
+                if (buffer.capacity < count) {
+                    buffer.flags.reset(new bool[count]);
+                    buffer.capacity = count;
+                }
+
+                buffer.busy = true;
+                m_borrowed = true;
+
+                return buffer.flags.get();
+            }
+    };
+
+    /**
+     * Consumes the signal being delivered by the calling thread's innermost dispatch. Does nothing outside 
+     * of a dispatch.
+     */
+    inline void consume() {
+        dispatch_context* frame = dispatch_context::current();
+        if (frame) {
+            frame->consume();
+        }
+    }
+};
\ No newline at end of file
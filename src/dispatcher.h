@@ -26,20 +26,81 @@
 
 #pragma once
 
+#include <algorithm>
+#include <cassert>
 #include <vector>
 #include <memory>
-#include <unordered_map>
-#include <mutex>
+#include <atomic>
 #include <functional>
 #include <type_traits>
 #include <typeinfo>
-#include <typeindex>
 #include "listener.h"
+#include "listener_list.h"
+#include "event.h"
+#include "signal_id.h"
+#include "signal_hierarchy.h"
+#include "signal_key.h"
+#include "signal_table.h"
+#include "sticky.h"
+#include "coalesce.h"
+#include "subscription.h"
+#include "thread_pool.h"
+#include "instrumentation.h"
 #include "helpers.h"
 
 
 namespace dispatch {
+
+    template<class T> class signal_awaiter;
+    template<class T> class signal_stream;
     
+    /**
+     * Opt-in parallel fan-out for a signal type. See <code>dispatcher::set_parallel</code>.
+     */
+    struct parallel_policy {
+        thread_pool* pool;
+
+        /**
+         * The fewest listeners a dispatch must have to run in parallel.
+         */
+        std::size_t threshold;
+
+        /**
+         * Listeners per task, or 0 to split evenly across the pool and the dispatching thread.
+         */
+        std::size_t grain;
+    };
+
+    /**
+     * Where a dispatcher's memory goes. See <code>dispatcher::memory_usage</code>.
+     */
+    struct memory_usage_info {
+        /**
+         * The dispatcher itself, and what it keeps per signal type it knows of, whether or not the type still
+         * has listeners.
+         */
+        std::size_t dispatcher;
+
+        /**
+         * Held by listener lists, including keyed listeners, unused capacity and targets too large to be stored 
+         * in place.
+         */
+        std::size_t listeners;
+
+        std::size_t subscriptions;
+
+        std::size_t total() const {
+            return dispatcher + listeners;
+        }
+
+        /**
+         * The listener bytes per subscription, or zero if there are none.
+         */
+        std::size_t per_subscription() const {
+            return subscriptions ? listeners / subscriptions : 0;
+        }
+    };
+
     /**
      * This class is used to dispatch signals to various listeners.
      */
@@ -61,40 +122,190 @@ namespace dispatch {
             //  methods
             //----------------------------------
 
+            /**
+             * Adds a listener. Listeners run from highest to lowest <code>priority</code>, and in the order
+             * they were added within a priority. A listener tracked by <code>life</code> stops being invoked
+             * once its owner is gone, and is removed by the next <code>prune</code>.
+             */
+            template<class T, class = typename std::enable_if<!is_event<T>::value>::type>
+            subscription add(listener<T> l, int priority = 0, lifetime life = lifetime()) {
+                signal_hierarchy<T>::steps();
+
+                const T* value = latest<T>();
+                if (value && life.alive()) {
+                    replay(l.callable(), *value);
+                }
+
+                return insert(typed_state_for<T>(), signal_id<T>::value(), std::move(l.callable()), l.address(), priority, std::move(life));
+            }
+
+            /**
+             * Adds a listener which receives signals of <code>T</code> as a contiguous batch. Single dispatches
+             * arrive as a batch of one.
+             */
             template<class T>
-            void add(listener<T>* ptr) {
-                //typedef typename remove_all_qualifiers<T>::type TT;
-                std::type_index key(typeid(T));
-                m_listeners[key].emplace_back(ptr);
+            subscription add_batch(batch_delegate<T> callable, std::uintptr_t addr, int priority = 0, lifetime life = lifetime()) {
+                const T* value = latest<T>();
+                if (value && life.alive()) {
+                    T copy(*value);
+                    dispatch_context frame;
+                    callable(&copy, std::size_t(1));
+                }
+
+                return insert(typed_state_for<batch_of<T>>(), signal_id<batch_of<T>>::value(), std::move(callable), addr, priority, std::move(life));
+            }
+
+            /**
+             * Adds a listener which only receives signals of <code>T</code> whose key (see <code>signal_key</code>)
+             * equals <code>key</code>. Dispatching looks the key up once, so listeners for other keys cost nothing.
+             * Keyed listeners run before the unkeyed listeners of <code>T</code>, and are removed through their
+             * subscription.
+             */
+            template<class T>
+            subscription add_keyed(const typename signal_key<T>::type& key, listener<T> l, int priority = 0, lifetime life = lifetime()) {
+                typedef typename signal_key<T>::type K;
+
+                signal_hierarchy<T>::steps();
+
+                const T* value = latest<T>();
+                if (value && life.alive() && signal_key<T>::of(*value) == key) {
+                    replay(l.callable(), *value);
+                }
+
+                signal_state& state = typed_state_for<T>();
+                if (!state.keyed) {
+                    state.keyed.reset(new keyed_lists<K>());
+                }
+
+                std::uint32_t bucket = static_cast<keyed_lists<K>&>(*state.keyed).bucket_for(key);
+                auto slot = state.keyed->bucket(bucket).push_back(std::move(l.callable()), l.address(), priority, std::move(life));
+
+                return subscription(static_cast<std::uint32_t>(signal_id<T>::value()), slot.first, slot.second, bucket + 1);
+            }
+
+            /**
+             * Adds a heap allocated listener, taking ownership of it.
+             */
+            template<class T>
+            subscription add(listener<T>* ptr, int priority = 0) {
+                std::unique_ptr<listener<T>> owned(ptr);
+                return add(std::move(*owned), priority);
+            }
+
+            /**
+             * Adds a listener for the event <code>E</code> (see <code>event</code>). <code>callable</code> must be
+             * invocable with the event's parameters. Events support priorities and tracking, but not hierarchies,
+             * keys, stickiness, coalescing or consuming.
+             */
+            template<class E, class F>
+            typename std::enable_if<is_event<E>::value, subscription>::type add(const F& callable, int priority = 0, lifetime life = lifetime()) {
+                delegate<typename E::signature> target(callable);
+                return insert(typed_state_for<E>(), signal_id<E>::value(), std::move(target), pointer_memory<F>::address_for(callable), priority, std::move(life));
+            }
+
+            /**
+             * Removes the first listener of the event <code>E</code> added from <code>callable</code>.
+             */
+            template<class E, class F>
+            typename std::enable_if<is_event<E>::value>::type remove(const F& callable) {
+                assert_outside_fan_out();
+
+                signal_state* state = m_signals.find(signal_id<E>::value());
+                if (state) {
+                    state->listeners.remove(pointer_memory<F>::address_for(callable));
+                }
             }
 
+            /**
+             * Removes the first listener added from <code>dispatchListener</code>. Event listeners can't be 
+             * told apart from signal listeners by their parameters, so they're removed with 
+             * <code>remove&lt;E&gt;(callable)</code> or through their subscription.
+             */
             template<class E>
             void remove(const E& dispatchListener) {
-                typedef function_param_at<function_type_for_t<E>, 0> T;
-                //typedef typename remove_all_qualifiers<T>::type TT;
+                typedef typename listener_signal<function_type_for_t<E>>::key T;
+                static_assert(
+                    std::is_base_of<signal, typename listener_signal<function_type_for_t<E>>::type>::value, 
+                    "remove: the listener doesn't take a signal. Remove event listeners with remove<E>(callable).");
             
                 std::uintptr_t addr = pointer_memory<E>::address_for(dispatchListener);
 
-                std::type_index key(typeid(T));
-                std::vector<handler_t>* v = &m_listeners[key];
+                assert_outside_fan_out();
 
-                auto result = std::find_if(v->begin(), v->end(), [&addr](const handler_t& check) {
-                    auto lptr = std::static_pointer_cast<listener<T>>(check);
-                    return *lptr == addr;
-                });
+                signal_state* state = m_signals.find(signal_id<T>::value());
+                if (state && state->listeners.remove(addr) && state->listeners.empty()) {
+                    reroute(*state);
+                }
+            }
+
+            /**
+             * Removes the listener behind <code>handle</code> in constant time. Returns false if the handle
+             * is stale.
+             */
+            bool remove(const subscription& handle) {
+                assert_outside_fan_out();
+
+                signal_state* found = m_signals.find(handle.id);
+                if (!found) {
+                    return false;
+                }
+
+                signal_state& state = *found;
+                if (handle.bucket != 0) {
+                    if (!state.keyed 
+                        || handle.bucket > state.keyed->bucket_count()
+                        || !state.keyed->bucket(handle.bucket - 1).remove(handle.slot, handle.generation)) {
+                        return false;
+                    }
+
+                    state.keyed->reclaim(handle.bucket - 1);
+                    return true;
+                }
 
-                if (result != v->end()) {
-                    v->erase(result);
+                if (!state.listeners.remove(handle.slot, handle.generation)) {
+                    return false;
                 }
+
+                if (state.listeners.empty()) {
+                    reroute(state);
+                }
+
+                return true;
             }
 
             template<class T>
-            inline dispatcher& operator+=(const T& dispatchListener) {
-                wrap_add(
+            inline subscription operator+=(const T& dispatchListener) {
+                return wrap_add(
                     function_wrapper<T>::wrap(dispatchListener),
-                    pointer_memory<T>::address_for(dispatchListener));
+                    pointer_memory<T>::address_for(dispatchListener),
+                    0);
+            }
 
-                return *this;
+            template<class T>
+            inline subscription operator+=(const prioritized<T>& dispatchListener) {
+                typedef typename std::decay<T>::type F;
+
+                return wrap_add(
+                    function_wrapper<F>::wrap(dispatchListener.callable),
+                    pointer_memory<F>::address_for(dispatchListener.callable),
+                    dispatchListener.priority);
+            }
+
+            template<class T>
+            inline subscription operator+=(const tracked<T>& dispatchListener) {
+                return add(dispatchListener.target, 0, dispatchListener.life);
+            }
+
+            template<class K, class T>
+            inline subscription operator+=(const keyed<K, T>& dispatchListener) {
+                typedef typename std::decay<T>::type F;
+                typedef typename std::decay<function_param_at<F, 0>>::type E;
+
+                return add_keyed<E>(
+                    dispatchListener.key, 
+                    listener<E>(
+                        function_wrapper<F>::wrap(dispatchListener.callable), 
+                        pointer_memory<F>::address_for(dispatchListener.callable)));
             }
 
             template<class T>
@@ -104,29 +315,941 @@ namespace dispatch {
                 return *this;
             }
 
+            inline dispatcher& operator-=(const subscription& handle) {
+                remove(handle);
+
+                return *this;
+            }
+
+            /**
+             * Delivers <code>value</code> to every listener of <code>T</code> and of its declared base types 
+             * (see <code>signal_bases</code>), then to every batch listener of <code>T</code> as a batch of one. 
+             * The signal is passed through by reference and the listener lists are swept in place, so no copy 
+             * of the payload, no refcount traffic and no allocation happens on the dispatching side.
+             *
+             * When <code>value</code> is a more derived type than <code>T</code>, it's routed by its dynamic type 
+             * if that type is known (see <code>signal_registry</code>).
+             *
+             * A listener that calls <code>consume()</code> stops the signal there: lower priority listeners, base
+             * type listeners and batch listeners don't see it. Consumption belongs to this dispatch (see
+             * <code>dispatch_context</code>), <code>value</code> isn't written to.
+             *
+             * Keyed listeners only receive signals dispatched as their exact type.
+             *
+             * For a sticky type (see <code>set_sticky</code>) the value is kept as the latest one first, and with
+             * <code>coalesce_unchanged</code> the whole dispatch is skipped if the value is unchanged. For a 
+             * coalesced type (see <code>set_coalescing</code>) the value is only merged into the pending one.
+             */
             template<class T> 
-            void dispatch(T value) {
-                static_assert(std::is_base_of<signal, full_decay_t<T>>::value, "T type must implement signal.");
+            void dispatch(const T& value) {
+                deliver(value, true);
+            }
+
+            /**
+             * Calls every listener of the event <code>E</code> with <code>args</code>, converted to the event's 
+             * parameter types.
+             */
+            template<class E, class...Args>
+            typename std::enable_if<is_event<E>::value>::type dispatch(Args&&...args) {
+                assert_outside_fan_out();
+
+                signal_state* state = m_signals.find(signal_id<E>::value());
+                if (state) {
+                    // Events can't be consumed, the frame only keeps consume() from reaching an outer dispatch.
+                    dispatch_context frame;
+                    dispatch_timer timer(metrics_of(*state));
+                    event_invoker<typename E::signature>::invoke(state->listeners, std::forward<Args>(args)...);
+                }
+            }
+
+            /**
+             * Delivers <code>count</code> signals at once. Listener lists are resolved once for the whole batch.
+             * Batch listeners receive the entire array in one call, and each regular listener receives every 
+             * signal in order before the next listener runs. A consumed signal is skipped by the remaining regular
+             * listeners, but batch listeners always receive the whole array. Keyed listeners receive their signals 
+             * first, one at a time. A sticky type keeps the last signal of the batch, without coalescing. A 
+             * coalesced type merges every signal of the batch into its pending value.
+             */
+            template<class T>
+            void dispatch_batch(const T* values, std::size_t count) {
+                static_assert(std::is_base_of<signal, T>::value, "T type must implement signal.");
+
+                if (count == 0) {
+                    return;
+                }
+
+                assert_outside_fan_out();
+
+                dispatch_context frame(count);
+
+                std::size_t id = signal_id<T>::value();
+                signal_state* state = routed_state(id, signal_hierarchy<T>::steps());
+                if (state) {
+                    instrument(*state, typeid(T));
+
+                    if (state->coalesce) {
+                        bool first = false;
+                        for (std::size_t i = 0; i < count; ++i) {
+                            first |= state->coalesce->absorb(&values[i]);
+                        }
+                        if (first) {
+                            extra().pending.push_back(id);
+                        }
+                        return;
+                    }
 
-                std::type_index key(typeid(T));
-                for (auto f : m_listeners[key]) {
-                    std::shared_ptr<listener<T>> ptr = std::static_pointer_cast<listener<T>>(f);
-                    (*ptr)(value);
+                    if (state->sticky) {
+                        static_cast<sticky_value<T>&>(*state->sticky).store(&values[count - 1]);
+                    }
+
+                    {
+                        dispatch_timer timer(metrics_of(*state));
+                        dispatch_keyed(*state, values, count, frame, has_signal_key<T>());
+
+                        if (state->parallel && state->listeners.extent() >= state->parallel->threshold) {
+                            dispatch_parallel(*state, values, count, frame);
+                        } else {
+                            state->listeners.dispatch_each(values, count, frame);
+                        }
+                    }
+
+                    // By index, as a listener's nested dispatch may rebuild the route.
+                    for (std::size_t i = 0; i < state->route.size(); ++i) {
+                        route_entry step = state->route[i];
+                        dispatch_timer timer(metrics_of(*step.base));
+
+                        step.step.visit_each(step.base->listeners, values, count, frame);
+                    }
+                }
+
+                signal_state* batch = m_signals.find(signal_id<batch_of<T>>::value());
+                if (batch) {
+                    dispatch_timer timer(metrics_of(*batch));
+
+                    batch->listeners.template invoke<void(const T*, std::size_t)>(values, count);
+                }
+            }
+
+            template<class T>
+            inline void dispatch_batch(const T* first, const T* last) {
+                dispatch_batch(first, static_cast<std::size_t>(last - first));
+            }
+
+            /**
+             * Dispatches the contents of a contiguous container (ie: <code>std::vector</code> or <code>std::array</code>).
+             */
+            template<class C>
+            inline void dispatch_batch(const C& values) {
+                dispatch_batch(values.data(), values.size());
+            }
+
+            /**
+             * Opts <code>T</code> in to parallel fan-out. Dispatches of <code>T</code> with at least 
+             * <code>threshold</code> listeners split the listener list into chunks of <code>grain</code> 
+             * (0 splits evenly) and run them on <code>pool</code> and the dispatching thread, returning once 
+             * every listener has run. Below the threshold listeners run sequentially as usual.
+             *
+             * Listeners of a parallel type run concurrently with each other and must be thread safe. They must not
+             * add or remove listeners, or dispatch, through this dispatcher: it isn't thread safe, and the pool 
+             * threads would race with each other and with the dispatching thread. Debug builds assert it. Priorities 
+             * only decide which chunk a listener lands in, and <code>consume()</code> has no effect. A throwing
+             * listener doesn't keep the others from running. Exceptions are collected and rethrown from 
+             * <code>dispatch</code> once every listener has run: a single exception as-is, several as a
+             * <code>parallel_error</code>.
+             */
+            template<class T>
+            void set_parallel(std::size_t threshold, std::size_t grain = 0, thread_pool& pool = thread_pool::shared()) {
+                parallel_policy policy = { &pool, std::max<std::size_t>(threshold, 1), grain };
+                typed_state_for<T>().parallel.reset(new parallel_policy(policy));
+            }
+
+            /**
+             * Returns <code>T</code> to sequential dispatch.
+             */
+            template<class T>
+            void set_sequential() {
+                signal_state* state = m_signals.find(signal_id<T>::value());
+                if (state) {
+                    state->parallel.reset();
+                }
+            }
+
+            /**
+             * Makes <code>T</code> sticky: the dispatcher keeps the latest dispatched <code>T</code>, and every 
+             * listener of <code>T</code> added afterwards receives it right away. Batch listeners receive it as a
+             * batch of one, and keyed listeners only if the key matches. Listeners of base types don't.
+             *
+             * The value is replayed from inside <code>add</code>, before the listener is subscribed. Consuming it
+             * only affects the replay, signals the listener dispatches don't reach it, and it can't remove itself
+             * yet: it's subscribed once <code>add</code> returns either way. It receives a copy, so dispatching
+             * <code>T</code> or clearing stickiness from the replay doesn't change the value it's holding.
+             */
+            template<class T>
+            void set_sticky() {
+                make_sticky<T>(new sticky_value<T>());
+            }
+
+            /**
+             * Makes <code>T</code> sticky, and skips any dispatch of a value equal (<code>==</code>) to the latest 
+             * one, so redundant updates don't fan out at all.
+             */
+            template<class T>
+            void set_sticky(coalesce_unchanged_t coalesce) {
+                make_sticky<T>(new sticky_value<T>(coalesce));
+            }
+
+            /**
+             * Makes <code>T</code> a regular signal again, dropping the latest value.
+             */
+            template<class T>
+            void clear_sticky() {
+                signal_state* state = m_signals.find(signal_id<T>::value());
+                if (state) {
+                    state->sticky.reset();
+                }
+            }
+
+            /**
+             * The latest value of the sticky type <code>T</code>, or null if there isn't one.
+             */
+            template<class T>
+            const T* latest() const {
+                const signal_state* state = m_signals.find(signal_id<T>::value());
+                if (!state || !state->sticky) {
+                    return nullptr;
+                }
+
+                return static_cast<const sticky_value<T>&>(*state->sticky).get();
+            }
+
+            /**
+             * Coalesces <code>T</code>: a dispatch no longer runs any listeners, it's merged into a single pending
+             * value which the next <code>flush</code> delivers. Without a <code>reducer</code> the latest value 
+             * wins, otherwise <code>reducer(pending, next)</code> merges each event into the pending value. A value
+             * already pending from an earlier mode is delivered first.
+             */
+            template<class T>
+            void set_coalescing(typename coalesced_value<T>::reducer_t reducer = nullptr) {
+                static_assert(std::is_base_of<signal, T>::value, "T type must implement signal.");
+
+                clear_coalescing<T>();
+
+                std::unique_ptr<coalesced_value_base> coalesce(new coalesced_value<T>(&flush_pending<T>, std::move(reducer)));
+                typed_state_for<T>().coalesce = std::move(coalesce);
+            }
+
+            /**
+             * Delivers the pending value of <code>T</code>, if any, and returns <code>T</code> to immediate dispatch.
+             */
+            template<class T>
+            void clear_coalescing() {
+                signal_state* state = m_signals.find(signal_id<T>::value());
+                if (!state || !state->coalesce) {
+                    return;
+                }
+
+                std::unique_ptr<coalesced_value_base> coalesce(std::move(state->coalesce));
+                static_cast<coalesced_value<T>&>(*coalesce).take([this](const T& value) { deliver(value, false); });
+            }
+
+            /**
+             * The number of events merged into the pending value of <code>T</code> so far.
+             */
+            template<class T>
+            std::size_t coalesced_events() const {
+                const signal_state* state = m_signals.find(signal_id<T>::value());
+                if (!state || !state->coalesce) {
+                    return 0;
+                }
+
+                return state->coalesce->events();
+            }
+
+            /**
+             * Delivers every pending coalesced value, in the order each type's first event arrived, and returns
+             * how many events they stood for. Signals coalesced by listeners during the flush wait for the next 
+             * one, and a nested <code>flush</code> does nothing.
+             */
+            std::size_t flush() {
+                if (!m_extra || !m_extra->flushing.empty()) {
+                    return 0;
+                }
+
+                std::vector<std::size_t>& pending = m_extra->pending;
+                std::vector<std::size_t>& flushing = m_extra->flushing;
+                flushing.swap(pending);
+
+                std::size_t events = 0;
+                std::size_t i = 0;
+                try {
+                    for (; i < flushing.size(); ++i) {
+                        signal_state& state = *m_signals.find(flushing[i]);
+                        if (state.coalesce) {
+                            events += state.coalesce->flush(*this, flushing[i]);
+                        }
+                    }
+                } catch (...) {
+                    // Whatever hasn't been delivered yet stays pending.
+                    pending.insert(pending.end(), flushing.begin() + i + 1, flushing.end());
+                    flushing.clear();
+                    throw;
+                }
+
+                flushing.clear();
+                return events;
+            }
+
+            /**
+             * Removes every tracked listener whose owner is gone. Dead listeners are never invoked, and a list
+             * that runs into one prunes itself once the dispatch returns, so calling this is only needed to 
+             * release listeners whose type isn't being dispatched.
+             */
+            void prune() {
+                for (signal_table<signal_state>::entry& entry : m_signals) {
+                    signal_state& state = *entry.state;
+                    bool empty = state.listeners.empty();
+
+                    state.listeners.prune();
+                    if (!empty && state.listeners.empty()) {
+                        reroute(state);
+                    }
+
+                    if (state.keyed) {
+                        for (std::uint32_t i = 0; i < state.keyed->bucket_count(); ++i) {
+                            state.keyed->bucket(i).prune();
+                            state.keyed->reclaim(i);
+                        }
+                    }
+                }
+            }
+
+            /**
+             * Returns an awaitable which resumes the awaiting coroutine with the next <code>T</code> dispatched,
+             * straight from the dispatch loop. Defined in <code>awaitable.h</code>, which needs C++20 coroutines.
+             */
+            template<class T>
+            signal_awaiter<T> next(int priority = 0);
+
+            /**
+             * Returns a stream which stays subscribed to <code>T</code> for as long as it lives, so a coroutine
+             * can await one signal after another. Defined in <code>awaitable.h</code>.
+             */
+            template<class T>
+            signal_stream<T> stream(int priority = 0);
+
+            /**
+             * Returns the bytes this dispatcher holds, itself included. An idle dispatcher is two pointers and 
+             * allocates nothing, and each signal type costs a fixed amount once subscribed to.
+             */
+            memory_usage_info memory_usage() const {
+                memory_usage_info usage = { sizeof(dispatcher) + m_signals.block_bytes(), 0, 0 };
+
+                if (m_extra) {
+                    usage.dispatcher += sizeof(extra_state)
+                        + m_extra->dynamic.capacity() * sizeof(dynamic_type)
+                        + (m_extra->pending.capacity() + m_extra->flushing.capacity()) * sizeof(std::size_t);
+                }
+
+                for (const signal_table<signal_state>::entry& entry : m_signals) {
+                    const signal_state& state = *entry.state;
+
+                    usage.dispatcher += sizeof(signal_state) 
+                        + state.route.capacity() * sizeof(route_entry) 
+                        + state.dependents.capacity() * sizeof(signal_state*);
+                    if (state.parallel) {
+                        usage.dispatcher += sizeof(parallel_policy);
+                    }
+                    if (state.sticky) {
+                        usage.dispatcher += state.sticky->memory_usage();
+                    }
+                    if (state.coalesce) {
+                        usage.dispatcher += state.coalesce->memory_usage();
+                    }
+#ifdef DISPATCH_INSTRUMENTATION
+                    if (state.metrics) {
+                        usage.dispatcher += sizeof(signal_metrics);
+                    }
+#endif
+
+                    usage.listeners += state.listeners.memory_usage();
+                    usage.subscriptions += state.listeners.size();
+
+                    if (state.keyed) {
+                        usage.listeners += state.keyed->memory_usage();
+                        for (std::uint32_t i = 0; i < state.keyed->bucket_count(); ++i) {
+                            usage.subscriptions += state.keyed->bucket(i).size();
+                        }
+                    }
+                }
+
+                return usage;
+            }
+
+            /**
+             * Returns a snapshot of the metrics for every signal type this dispatcher has seen. Metrics are only
+             * collected when <code>DISPATCH_INSTRUMENTATION</code> is defined, otherwise the result is empty 
+             * and dispatching carries no instrumentation code at all.
+             */
+            std::vector<signal_stats> statistics() const {
+                std::vector<signal_stats> result;
+#ifdef DISPATCH_INSTRUMENTATION
+                for (const signal_table<signal_state>::entry& entry : m_signals) {
+                    const signal_state& state = *entry.state;
+                    const std::size_t id = entry.id;
+                    if (!state.metrics) {
+                        continue;
+                    }
+
+                    const latency_histogram& latency = state.metrics->latency;
+                    signal_stats stats = {
+                        id,
+                        state.metrics->name.c_str(),
+                        latency.count(),
+                        state.listeners.size(),
+                        latency.total(),
+                        latency.percentile(0.5),
+                        latency.percentile(0.99),
+                        latency.percentile(0.999),
+                        latency.max(),
+                        state.listeners.statistics(static_cast<std::uint32_t>(id))
+                    };
+                    result.push_back(std::move(stats));
                 }
+#endif
+                return result;
             }
 
         private:
-            typedef std::shared_ptr<handler> handler_t;
+            struct signal_state;
+
+            /**
+             * A base type a dispatch visits after its own type, and the state holding its listeners.
+             */
+            struct route_entry {
+                route_step step;
+                signal_state* base;
+            };
 
-            std::unordered_map<std::type_index, std::vector<handler_t>> m_listeners;
+            /**
+             * Everything the dispatcher keeps per signal type.
+             */
+            struct signal_state {
+                listener_list listeners;
+                std::unique_ptr<parallel_policy> parallel;
+#ifdef DISPATCH_INSTRUMENTATION
+                std::unique_ptr<signal_metrics> metrics;
+#endif
+
+                /**
+                 * The base type lists a dispatch of this type visits after its own, limited to those with 
+                 * listeners. Rebuilt on the next dispatch after <code>routed</code> is cleared.
+                 */
+                std::vector<route_entry> route;
+                bool routed;
+
+                /**
+                 * The types whose route depends on this list, ie: derived types. Their routes are invalidated 
+                 * when this list gains its first listener or loses its last one.
+                 */
+                std::vector<signal_state*> dependents;
+                bool linked;
+
+                /**
+                 * Listeners subscribed with a key, or null if there are none.
+                 */
+                std::unique_ptr<keyed_lists_base> keyed;
+
+                /**
+                 * The latest value of a sticky type, or null if the type isn't sticky.
+                 */
+                std::unique_ptr<sticky_value_base> sticky;
+
+                /**
+                 * The pending value of a coalesced type, or null if the type isn't coalesced.
+                 */
+                std::unique_ptr<coalesced_value_base> coalesce;
+
+                signal_state() : routed(false), linked(false) { }
+            };
+
+            /**
+             * The id and ancestry of dynamic signal types seen by <code>dispatch</code>. Unknown types are
+             * remembered too, until the registry changes.
+             */
+            struct dynamic_type {
+                const std::type_info* type;
+                signal_registry::entry entry;
+                std::size_t generation;
+            };
+
+            /**
+             * State the dispatchers of most objects never need, allocated on first use.
+             */
+            struct extra_state {
+                std::vector<dynamic_type> dynamic;
+
+                /**
+                 * Coalesced types with a pending value, in the order their first event arrived. Swapped into 
+                 * <code>flushing</code> while flushing, so both keep their capacity.
+                 */
+                std::vector<std::size_t> pending;
+                std::vector<std::size_t> flushing;
+
+                /**
+                 * The number of parallel fan-outs running. Read from pool threads by 
+                 * <code>assert_outside_fan_out</code>.
+                 */
+                std::atomic<std::size_t> fan_outs{0};
+            };
+
+            /**
+             * Counts a parallel fan-out for as long as it runs.
+             */
+            class fan_out_scope {
+                public:
+                    explicit fan_out_scope(std::atomic<std::size_t>& _fan_outs) 
+                        : m_fan_outs(_fan_outs) 
+                    {
+                        m_fan_outs.fetch_add(1, std::memory_order_relaxed);
+                    }
+
+                    fan_out_scope(const fan_out_scope&) = delete;
+                    fan_out_scope& operator=(const fan_out_scope&) = delete;
+
+                    ~fan_out_scope() {
+                        m_fan_outs.fetch_sub(1, std::memory_order_relaxed);
+                    }
+
+                private:
+                    std::atomic<std::size_t>& m_fan_outs;
+            };
+
+            /**
+             * Signal state by <code>signal_id</code>, only for the types that have been subscribed to (and their
+             * bases), so types nobody listens to cost nothing to dispatch and an idle dispatcher holds nothing.
+             * States never move, so a listener subscribing to a new type while another is being dispatched 
+             * doesn't move the state being dispatched.
+             */
+            signal_table<signal_state> m_signals;
+            std::unique_ptr<extra_state> m_extra;
+
+            extra_state& extra() {
+                if (!m_extra) {
+                    m_extra.reset(new extra_state());
+                }
+
+                return *m_extra;
+            }
+
+            /**
+             * Listeners of a parallel type may be running on pool threads while a fan-out is in progress, and
+             * nothing may add, remove or dispatch through the dispatcher until it joins. Only checked by debug
+             * builds. <code>m_extra</code> is never replaced once set, so this is safe to call from any thread.
+             */
+            void assert_outside_fan_out() const {
+                assert((!m_extra || m_extra->fan_outs.load(std::memory_order_relaxed) == 0)
+                    && "dispatch::dispatcher: listeners of a parallel type must not add, remove or dispatch");
+            }
+
+            signal_state& state_for(std::size_t id) {
+                assert_outside_fan_out();
+                return m_signals.get(id);
+            }
+
+            template<class T>
+            signal_state& typed_state_for() {
+                signal_state& state = state_for(signal_id<T>::value());
+                instrument(state, typeid(T));
+                return state;
+            }
+
+            /**
+             * Gives <code>state</code> metrics, named after <code>type</code>, if it has none yet. States are also
+             * made by routing a type nobody subscribed to, so dispatches instrument them too.
+             */
+            static void instrument(signal_state& state, const std::type_info& type) {
+#ifdef DISPATCH_INSTRUMENTATION
+                if (!state.metrics) {
+                    state.metrics.reset(new signal_metrics());
+                    state.metrics->name = type_name(type);
+                }
+#else
+                (void)state, (void)type;
+#endif
+            }
+
+            static signal_metrics* metrics_of(const signal_state& state) {
+#ifdef DISPATCH_INSTRUMENTATION
+                return state.metrics.get();
+#else
+                return (void)state, nullptr;
+#endif
+            }
         
+            template<class Sig>
+            subscription insert(signal_state& state, std::size_t id, delegate<Sig> callable, std::uintptr_t addr, int priority, lifetime life) {
+                bool first = state.listeners.empty();
+
+                auto slot = state.listeners.push_back(std::move(callable), addr, priority, std::move(life));
+                if (first) {
+                    reroute(state);
+                }
+
+                return subscription(static_cast<std::uint32_t>(id), slot.first, slot.second);
+            }
+
+            /**
+             * Invalidates the routes of every type derived from <code>state</code>'s type, after its list became
+             * empty or non-empty.
+             */
+            void reroute(const signal_state& state) {
+                for (signal_state* dependent : state.dependents) {
+                    dependent->routed = false;
+                }
+            }
+
+            /**
+             * Returns the state of the concrete type <code>id</code> with its route up to date, or null if 
+             * nothing could be listening to it. Types without bases and without listeners aren't given state.
+             */
+            signal_state* routed_state(std::size_t id, const std::vector<route_step>& ancestry) {
+                signal_state* found = m_signals.find(id);
+                if (!found && ancestry.size() == 1) {
+                    return nullptr;
+                }
+
+                signal_state& state = found ? *found : m_signals.get(id);
+                if (state.routed) {
+                    return &state;
+                }
+
+                state.route.clear();
+                for (std::size_t i = 1; i < ancestry.size(); ++i) {
+                    signal_state& base = m_signals.get(ancestry[i].id);
+                    if (!state.linked) {
+                        base.dependents.push_back(&state);
+                    }
+
+                    if (!base.listeners.empty()) {
+                        route_entry step = { ancestry[i], &base };
+                        state.route.push_back(step);
+                    }
+                }
+
+                state.linked = true;
+                state.routed = true;
+
+                return &state;
+            }
+
+            /**
+             * The body of <code>dispatch</code>. <code>flush</code> delivers coalesced values with 
+             * <code>coalesce</code> false.
+             */
+            template<class T> 
+            void deliver(const T& value, bool coalesce) {
+                static_assert(std::is_base_of<signal, T>::value, "T type must implement signal.");
+
+                assert_outside_fan_out();
+
+                dispatch_context frame;
+
+                // Signals dispatched through a base reference are delivered as their dynamic type when it's known.
+                // object always points to the concrete type's complete object.
+                std::size_t id = signal_id<T>::value();
+                const void* object = &value;
+                const signal_registry::entry* dynamic = nullptr;
+
+                if (&typeid(value) != &typeid(T)) {
+                    const signal_registry::entry& known = resolve(typeid(value));
+                    if (known.steps) {
+                        id = known.id;
+                        object = dynamic_cast<const void*>(&value);
+                        dynamic = &known;
+                    }
+                }
+
+                signal_state* state = routed_state(id, dynamic ? *dynamic->steps : signal_hierarchy<T>::steps());
+                if (state) {
+                    instrument(*state, dynamic ? typeid(value) : typeid(T));
+
+                    if (coalesce && state->coalesce) {
+                        if (state->coalesce->absorb(object)) {
+                            extra().pending.push_back(id);
+                        }
+                        return;
+                    }
+
+                    if (state->sticky && !state->sticky->store(object)) {
+                        return;
+                    }
+
+                    {
+                        dispatch_timer timer(metrics_of(*state));
+
+                        if (dynamic) {
+                            dynamic->steps->front().visit(state->listeners, object, frame);
+                        } else {
+                            dispatch_keyed(*state, &value, 1, frame, has_signal_key<T>());
+
+                            if (state->parallel && state->listeners.extent() >= state->parallel->threshold) {
+                                dispatch_parallel(*state, &value, 1, frame);
+                            } else {
+                                state->listeners.dispatch(value, frame);
+                            }
+                        }
+                    }
+
+                    visit_route(*state, object, frame);
+                }
+
+                signal_state* batch = m_signals.find(signal_id<batch_of<T>>::value());
+                if (batch && !frame.consumed()) {
+                    dispatch_timer timer(metrics_of(*batch));
+
+                    batch->listeners.template invoke<void(const T*, std::size_t)>(&value, std::size_t(1));
+                }
+            }
+
+            template<class T>
+            static std::size_t flush_pending(dispatcher& d, std::size_t id) {
+                coalesced_value<T>& pending = static_cast<coalesced_value<T>&>(*d.m_signals.find(id)->coalesce);
+                return pending.take([&d](const T& value) { d.deliver(value, false); });
+            }
+
+            template<class T>
+            void make_sticky(sticky_value<T>* value) {
+                static_assert(std::is_base_of<signal, T>::value, "T type must implement signal.");
+
+                std::unique_ptr<sticky_value_base> sticky(value);
+                typed_state_for<T>().sticky = std::move(sticky);
+            }
+
+            /**
+             * Delivers a copy of a sticky value to a listener that's being added, as the listener may replace
+             * or clear the stored value. It gets a frame of its own, so consuming the value doesn't consume the
+             * signal of a dispatch the listener is being added from.
+             */
+            template<class T>
+            static void replay(const delegate<void(const T&)>& callable, const T& value) {
+                T copy(value);
+                dispatch_context frame;
+                callable(copy);
+            }
+
+            template<class T>
+            static void dispatch_keyed(signal_state& state, const T* values, std::size_t count, dispatch_context& frame, std::true_type) {
+                if (!state.keyed) {
+                    return;
+                }
+
+                keyed_lists<typename signal_key<T>::type>& keyed = 
+                    static_cast<keyed_lists<typename signal_key<T>::type>&>(*state.keyed);
+
+                for (std::size_t i = 0; i < count; ++i) {
+                    const typename signal_key<T>::type& key = signal_key<T>::of(values[i]);
+                    listener_list* bucket = keyed.find(key);
+                    if (!bucket) {
+                        continue;
+                    }
+
+                    // Listeners that removed themselves, or expired, may have left the bucket empty.
+                    frame.select(i);
+                    bucket->dispatch(values[i], frame);
+                    if (bucket->empty()) {
+                        keyed.reclaim_key(key);
+                    }
+                }
+            }
+
+            template<class T>
+            static void dispatch_keyed(signal_state&, const T*, std::size_t, dispatch_context&, std::false_type) { }
+
+            void visit_route(const signal_state& state, const void* value, dispatch_context& frame) {
+                // By index, as a listener's nested dispatch may rebuild the route.
+                for (std::size_t i = 0; i < state.route.size(); ++i) {
+                    route_entry step = state.route[i];
+                    dispatch_timer timer(metrics_of(*step.base));
+
+                    step.step.visit(step.base->listeners, value, frame);
+                }
+            }
+
+            const signal_registry::entry& resolve(const std::type_info& type) {
+                signal_registry& registry = signal_registry::instance();
+                std::vector<dynamic_type>& dynamic = extra().dynamic;
+
+                for (dynamic_type& known : dynamic) {
+                    if (known.type != &type) {
+                        continue;
+                    }
+
+                    if (!known.entry.steps && known.generation != registry.generation()) {
+                        known.entry = registry.find(type);
+                        known.generation = registry.generation();
+                    }
+
+                    return known.entry;
+                }
+
+                dynamic_type known = { &type, registry.find(type), registry.generation() };
+                dynamic.push_back(known);
+
+                return dynamic.back().entry;
+            }
+
+            template<class T>
+            void dispatch_parallel(signal_state& state, const T* values, std::size_t count, const dispatch_context& frame) {
+                listener_list::dispatch_scope scope(state.listeners);
+                fan_out_scope fanning_out(extra().fan_outs);
+
+                // Chunks only read the frame, so nothing may consume into it: listeners running on this thread
+                // consume into isolated instead, and pool threads aren't running under this dispatch's frame.
+                dispatch_context isolated;
+
+                const listener_list& listeners = state.listeners;
+                thread_pool& pool = *state.parallel->pool;
+
+                std::size_t extent = listeners.extent();
+                std::size_t grain = state.parallel->grain;
+                if (grain == 0) {
+                    grain = (extent + pool.size()) / (pool.size() + 1);
+                }
+
+                // A throwing listener doesn't stop the rest of its chunk. Every failure is collected and rethrown
+                // once the fan-out has joined. Chunks only read the list; expired listeners they skip are marked 
+                // on this thread after the join.
+                std::atomic<bool> stale(false);
+                pool.parallel_for(extent, grain, [&listeners, &stale, &frame, values, count](std::size_t begin, std::size_t end) {
+                    std::vector<std::exception_ptr> errors;
+                    bool expired = false;
+                    for (std::size_t i = begin; i < end; ++i) {
+                        try {
+                            expired |= listeners.dispatch_each(i, i + 1, values, count, frame);
+                        } catch (...) {
+                            errors.push_back(std::current_exception());
+                        }
+                    }
+
+                    if (expired) {
+                        stale.store(true, std::memory_order_relaxed);
+                    }
+
+                    if (errors.size() == 1) {
+                        std::rethrow_exception(errors.front());
+                    }
+
+                    if (!errors.empty()) {
+                        throw parallel_error(std::move(errors));
+                    }
+                });
+
+                if (stale.load(std::memory_order_relaxed)) {
+                    state.listeners.mark_stale();
+                }
+            }
+
+            template<class T>
+            subscription wrap_add(const T& dispatchListener, std::uintptr_t addr, int priority) {
+                return wrap_add(dispatchListener, addr, priority, is_batch_listener<T>());
+            }
+
+            template<class T>
+            subscription wrap_add(const T& dispatchListener, std::uintptr_t addr, int priority, std::false_type) {
+                typedef typename std::decay<function_param_at<T, 0>>::type E;
+                return add(listener<E>(dispatchListener, addr), priority);
+            }
+
             template<class T>
-            void wrap_add(const T& dispatchListener, std::uintptr_t addr) {
-                typedef function_param_at<T, 0> E;
-                add(new listener<E>(dispatchListener, addr));
+            subscription wrap_add(const T& dispatchListener, std::uintptr_t addr, int priority, std::true_type) {
+                typedef typename listener_signal<T>::type E;
+                return add_batch<E>(dispatchListener, addr, priority);
             }
     };
 
     inline dispatcher::dispatcher() { }
     inline dispatcher::~dispatcher() { }
+
+    /**
+     * Removes its subscription from the dispatcher when destroyed. The dispatcher must outlive it.
+     */
+    class scoped_subscription {
+        public:
+            //----------------------------------
+            //  constructor
+            //----------------------------------
+
+            scoped_subscription() 
+                : m_dispatcher(nullptr) 
+            { }
+
+            scoped_subscription(dispatcher& d, const subscription& handle) 
+                : m_dispatcher(&d), 
+                  m_handle(handle) 
+            { }
+
+            scoped_subscription(scoped_subscription&& other) 
+                : m_dispatcher(other.m_dispatcher), 
+                  m_handle(other.release()) 
+            { }
+
+            scoped_subscription(const scoped_subscription&) = delete;
+            scoped_subscription& operator=(const scoped_subscription&) = delete;
+
+            //----------------------------------
+            //  destructor
+            //----------------------------------
+
+            ~scoped_subscription() { 
+                reset(); 
+            }
+
+            //----------------------------------
+            //  operators
+            //----------------------------------
+
+            scoped_subscription& operator=(scoped_subscription&& other) {
+                if (this != &other) {
+                    reset();
+                    m_dispatcher = other.m_dispatcher;
+                    m_handle = other.release();
+                }
+
+                return *this;
+            }
+
+            //----------------------------------
+            //  methods
+            //----------------------------------
+
+            const subscription& get() const {
+                return m_handle;
+            }
+
+            /**
+             * Detaches the handle without removing the listener.
+             */
+            subscription release() {
+                subscription handle = m_handle;
+                m_handle = subscription();
+                m_dispatcher = nullptr;
+                return handle;
+            }
+
+            /**
+             * Removes the listener now.
+             */
+            void reset() {
+                if (m_dispatcher && m_handle) {
+                    m_dispatcher->remove(m_handle);
+                }
+
+                m_handle = subscription();
+                m_dispatcher = nullptr;
+            }
+
+        private:
+            dispatcher* m_dispatcher;
+            subscription m_handle;
+    };
 };
\ No newline at end of file
@@ -0,0 +1,194 @@
+////////////////////////////////////////////////////////////////////////////////
+//
+// The MIT License (MIT)
+// 
+// Copyright (c) 2015 Matt Bolt
+// 
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+// 
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+// 
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+////////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <thread>
+
+
+namespace dispatch {
+
+    /**
+     * A process wide epoch domain used to tell when readers of copy-on-write data have moved on. Readers
+     * publish the epoch they entered in to a per-thread record (never shared, so entering and leaving
+     * scales with the number of threads), and writers advance the epoch and wait for, or poll for, every 
+     * record to catch up.
+     *
+     * A thread that calls <code>synchronize()</code> from inside its own read section is "parked" for the 
+     * duration of the wait, so two threads removing listeners from inside listeners can't wait on each other.
+     */
+    class epoch_domain {
+        private:
+            struct record;
+
+        public:
+            //----------------------------------
+            //  guard
+            //----------------------------------
+
+            /**
+             * Marks the calling thread as reading for the lifetime of the guard. Guards nest freely.
+             */
+            class guard {
+                public:
+                    guard() : m_record(epoch_domain::local()) { 
+                        if (m_record->depth++ == 0) {
+                            m_record->epoch.store(epoch_domain::global().m_epoch.load(std::memory_order_relaxed));
+                        }
+                    }
+
+                    ~guard() { 
+                        if (--m_record->depth == 0) {
+                            m_record->epoch.store(0, std::memory_order_release);
+                        }
+                    }
+
+                    guard(const guard&) = delete;
+                    guard& operator=(const guard&) = delete;
+
+                private:
+                    record* m_record;
+            };
+
+            //----------------------------------
+            //  methods
+            //----------------------------------
+
+            /**
+             * Advances the epoch and returns the new value. Anything unlinked before this call can be
+             * reclaimed once <code>is_quiescent(epoch)</code> returns true.
+             */
+            std::uint64_t advance() {
+                return m_epoch.fetch_add(1) + 1;
+            }
+
+            /**
+             * Advances the epoch and blocks until every other thread that was reading beforehand has left 
+             * its read section or is parked. Returns the new epoch.
+             */
+            std::uint64_t synchronize() {
+                std::uint64_t epoch = advance();
+                record* self = local();
+
+                self->parked.store(self->depth > 0);
+                for (record* r = m_records.load(std::memory_order_acquire); r; r = r->next) {
+                    if (r == self) {
+                        continue;
+                    }
+
+                    while (!r->parked.load()) {
+                        std::uint64_t e = r->epoch.load();
+                        if (e == 0 || e >= epoch) {
+                            break;
+                        }
+
+                        std::this_thread::yield();
+                    }
+                }
+                self->parked.store(false);
+
+                return epoch;
+            }
+
+            /**
+             * Determines whether or not every thread, including the calling thread, has left any read section
+             * that began before <code>epoch</code>.
+             */
+            bool is_quiescent(std::uint64_t epoch) const {
+                for (record* r = m_records.load(std::memory_order_acquire); r; r = r->next) {
+                    std::uint64_t e = r->epoch.load(std::memory_order_acquire);
+                    if (e != 0 && e < epoch) {
+                        return false;
+                    }
+                }
+
+                return true;
+            }
+
+            /**
+             * The domain shared by all concurrent dispatchers.
+             */
+            static epoch_domain& global() {
+                static epoch_domain domain;
+                return domain;
+            }
+
+        private:
+            /**
+             * Per-thread reader state, padded on both sides so each thread's writes stay on their own cache
+             * line. Records are recycled when their thread exits and are never freed.
+             */
+            struct record {
+                char leading_pad[64];
+                std::atomic<std::uint64_t> epoch;
+                std::atomic<bool> parked;
+                std::atomic<bool> in_use;
+                std::size_t depth;
+                record* next;
+                char trailing_pad[64];
+
+                record() : epoch(0), parked(false), in_use(true), depth(0), next(nullptr) { }
+            };
+
+            /**
+             * Returns the record to the domain when its thread exits.
+             */
+            struct record_owner {
+                record* r;
+
+                record_owner() : r(epoch_domain::global().acquire_record()) { }
+                ~record_owner() { r->in_use.store(false, std::memory_order_release); }
+            };
+
+            std::atomic<std::uint64_t> m_epoch;
+            std::atomic<record*> m_records;
+
+            epoch_domain() : m_epoch(1), m_records(nullptr) { }
+
+            static record* local() {
+                static thread_local record_owner owner;
+                return owner.r;
+            }
+
+            record* acquire_record() {
+                for (record* r = m_records.load(std::memory_order_acquire); r; r = r->next) {
+                    bool expected = false;
+                    if (r->in_use.compare_exchange_strong(expected, true, std::memory_order_acq_rel)) {
+                        return r;
+                    }
+                }
+
+                record* r = new record();
+                r->next = m_records.load(std::memory_order_relaxed);
+                while (!m_records.compare_exchange_weak(r->next, r, std::memory_order_acq_rel)) { }
+
+                return r;
+            }
+    };
+
+};
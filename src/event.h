@@ -0,0 +1,94 @@
+////////////////////////////////////////////////////////////////////////////////
+//
+// The MIT License (MIT)
+// 
+// Copyright (c) 2015 Matt Bolt
+// 
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+// 
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+// 
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+////////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include <type_traits>
+#include "listener_list.h"
+
+
+namespace dispatch {
+
+    namespace detail {
+
+        template<class...Args> struct event_params_valid 
+            : std::true_type { };
+
+        template<class A, class...Args> struct event_params_valid<A, Args...> 
+            : std::integral_constant<
+                bool,
+                !std::is_rvalue_reference<A>::value
+                    && (!std::is_lvalue_reference<A>::value || std::is_const<typename std::remove_reference<A>::type>::value)
+                    && event_params_valid<Args...>::value> { };
+
+    };
+
+    /**
+     * The base of a tag type naming an event whose payload is passed as plain arguments, rather than as a
+     * signal object:
+     *
+     *     struct on_move : public event<entity_id, float, float> { };
+     *
+     *     d.add<on_move>([](entity_id id, float x, float y) { ... });
+     *     d.dispatch<on_move>(id, x, y);
+     *
+     * Nothing is constructed to dispatch an event, and small arguments are passed to each listener in registers.
+     * Parameters are values or <code>const</code> references. Every listener gets its own copy of a value 
+     * parameter, so large payloads are better declared as <code>const</code> references.
+     */
+    template<class...Args> 
+    struct event {
+        static_assert(detail::event_params_valid<Args...>::value, "event parameters must be values or const references.");
+
+        typedef void signature(Args...);
+    };
+
+    namespace detail {
+
+        template<class...Args> std::true_type test_event(const event<Args...>*);
+        std::false_type test_event(...);
+
+    };
+
+    /**
+     * Whether or not <code>E</code> is an event tag type.
+     */
+    template<class E> struct is_event 
+        : decltype(detail::test_event(static_cast<const E*>(nullptr))) { };
+
+    template<class Sig> struct event_invoker;
+
+    /**
+     * Converts the arguments of a dispatch to the event's parameter types once, before they're handed to every 
+     * listener.
+     */
+    template<class...Params> struct event_invoker<void(Params...)> {
+        static void invoke(listener_list& listeners, Params...args) {
+            listeners.template invoke<void(Params...)>(args...);
+        }
+    };
+
+};
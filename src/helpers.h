@@ -44,6 +44,7 @@
 #include <tuple>
 #include <cstdlib>
 #include <cstring>
+#include "delegate.h"
 
 
 namespace dispatch {
@@ -270,6 +271,13 @@ namespace dispatch {
     template<template<class...> class T, class...Ts> struct function_in_binding<T<Ts...>> 
         : function_in_binding<Ts...> { };
 
+    /**
+     * libstdc++ and libc++ store the bound signature as a single <code>F(Args...)</code> function type 
+     * (ie: <code>_Bind<F(Args...)></code>), so we split it back out into the callable and its arguments.
+     */
+    template<class F, class...Ts> struct function_in_binding<F(Ts...)>
+        : function_in_binding<F, Ts...> { };
+
     /**
      * Hack: This implementation is specifically for deriving the MSVC implementation of std::bind
      */
@@ -311,6 +319,48 @@ namespace dispatch {
     using function_type_for_t = typename function_type_for<T>::type;
 
 
+    //--------------------------------
+    //  Signal Forwarding
+    //--------------------------------
+
+    /**
+     * Adapts the <code>const T&</code> handed out by the dispatcher to the parameter type a listener was 
+     * declared with. Value and <code>const&</code> parameters bind directly to the dispatched instance (a by-value
+     * parameter is the callee's own copy, made once at the call). Mutable and rvalue references receive a 
+     * temporary copy, so a listener can never change or move the payload out from under the caller and the
+     * listeners after it. The dispatched instance may well be a const object.
+     */
+    template<class P> struct signal_forward {
+        template<class T> 
+        static inline const T& apply(const T& s) { return s; }
+    };
+
+    /**
+     * A temporary copy of a signal which binds to a mutable reference parameter. It lives until the end of the
+     * call it's passed to.
+     */
+    template<class T> struct signal_copy {
+        T value;
+
+        operator T&() { return value; }
+    };
+
+    template<class P> struct signal_forward<P&> {
+        template<class T> 
+        static inline signal_copy<T> apply(const T& s) { return signal_copy<T>{ s }; }
+    };
+
+    template<class P> struct signal_forward<const P&> {
+        template<class T> 
+        static inline const T& apply(const T& s) { return s; }
+    };
+
+    template<class P> struct signal_forward<P&&> {
+        template<class T> 
+        static inline T apply(const T& s) { return T(s); }
+    };
+
+
     //--------------------------------
     //  Function Binding Wrapper
     //--------------------------------
@@ -326,13 +376,12 @@ namespace dispatch {
 
     template<class T>  struct function_wrapper<T, true> {
         typedef function_param_at<function_in_binding_t<T>, 0> E;
+        typedef typename std::decay<E>::type S;
         
-        static std::function<void(const E&)> wrap(const T& t) {
-            // We pass by reference to ensure that the memory address for the binding
-            // is consistent. In order to wrap the binding, we have to remove the const
-            // which gives us the original std::bind() result.
-            T& callable = const_cast<T&>(t);
-            return [&callable](const E& v) { callable(v); };
+        static delegate<void(const S&)> wrap(const T& t) {
+            // The binding is copied into the listener, so it doesn't matter when the caller's copy goes away.
+            // Removal by address still uses the caller's copy (see pointer_memory).
+            return [t](const S& v) mutable { t(signal_forward<E>::apply(v)); };
         }
     };
 
@@ -0,0 +1,263 @@
+////////////////////////////////////////////////////////////////////////////////
+//
+// The MIT License (MIT)
+// 
+// Copyright (c) 2015 Matt Bolt
+// 
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+// 
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+// 
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+////////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <string>
+#include <typeinfo>
+#include <vector>
+#include "subscription.h"
+
+#if defined(__GNUG__) && defined(__has_include)
+#if __has_include(<cxxabi.h>)
+#include <cxxabi.h>
+#define DISPATCH_DEMANGLE 1
+#endif
+#endif
+
+
+namespace dispatch {
+
+    /**
+     * A fixed size, lock-free latency histogram with HDR style log-linear buckets: every power of two is split
+     * into 16 linear sub-buckets, so any recorded value is reported within ~6% of its true value. Values are in
+     * nanoseconds and clamp at 2^40 (about 18 minutes). Recording is a handful of relaxed atomic increments.
+     */
+    class latency_histogram {
+        public:
+            static constexpr unsigned sub_bucket_bits = 4;
+            static constexpr std::uint64_t sub_buckets = 1 << sub_bucket_bits;
+            static constexpr unsigned max_bits = 40;
+            static constexpr std::size_t bucket_count = sub_buckets * (max_bits - sub_bucket_bits + 1);
+
+            //----------------------------------
+            //  constructor
+            //----------------------------------
+
+            latency_histogram() : m_count(0), m_total(0), m_max(0) {
+                for (std::size_t i = 0; i < bucket_count; ++i) {
+                    m_buckets[i].store(0, std::memory_order_relaxed);
+                }
+            }
+
+            latency_histogram(const latency_histogram&) = delete;
+            latency_histogram& operator=(const latency_histogram&) = delete;
+
+            //----------------------------------
+            //  methods
+            //----------------------------------
+
+            void record(std::uint64_t ns) {
+                m_buckets[index_for(ns)].fetch_add(1, std::memory_order_relaxed);
+                m_count.fetch_add(1, std::memory_order_relaxed);
+                m_total.fetch_add(ns, std::memory_order_relaxed);
+
+                std::uint64_t seen = m_max.load(std::memory_order_relaxed);
+                while (ns > seen && !m_max.compare_exchange_weak(seen, ns, std::memory_order_relaxed)) { }
+            }
+
+            std::uint64_t count() const {
+                return m_count.load(std::memory_order_relaxed);
+            }
+
+            std::uint64_t total() const {
+                return m_total.load(std::memory_order_relaxed);
+            }
+
+            std::uint64_t max() const {
+                return m_max.load(std::memory_order_relaxed);
+            }
+
+            /**
+             * The value at quantile <code>q</code> (0 to 1), reported as the midpoint of its bucket.
+             */
+            std::uint64_t percentile(double q) const {
+                std::uint64_t total = count();
+                if (total == 0) {
+                    return 0;
+                }
+
+                std::uint64_t rank = static_cast<std::uint64_t>(q * (total - 1)) + 1;
+                std::uint64_t seen = 0;
+                for (std::size_t i = 0; i < bucket_count; ++i) {
+                    seen += m_buckets[i].load(std::memory_order_relaxed);
+                    if (seen >= rank) {
+                        return lower_bound(i) + width(i) / 2;
+                    }
+                }
+
+                return max();
+            }
+
+        private:
+            std::atomic<std::uint64_t> m_buckets[bucket_count];
+            std::atomic<std::uint64_t> m_count;
+            std::atomic<std::uint64_t> m_total;
+            std::atomic<std::uint64_t> m_max;
+
+            static unsigned msb(std::uint64_t v) {
+#if defined(__GNUC__) || defined(__clang__)
+                return 63 - static_cast<unsigned>(__builtin_clzll(v));
+#else
+                unsigned bit = 0;
+                while (v >>= 1) {
+                    ++bit;
+                }
+                return bit;
+#endif
+            }
+
+            static std::size_t index_for(std::uint64_t v) {
+                if (v < sub_buckets) {
+                    return static_cast<std::size_t>(v);
+                }
+
+                if (v >= (std::uint64_t(1) << max_bits)) {
+                    return bucket_count - 1;
+                }
+
+                unsigned shift = msb(v) - sub_bucket_bits;
+                return static_cast<std::size_t>(sub_buckets * (shift + 1) + ((v >> shift) - sub_buckets));
+            }
+
+            static std::uint64_t lower_bound(std::size_t index) {
+                if (index < sub_buckets) {
+                    return index;
+                }
+
+                std::size_t shift = index / sub_buckets - 1;
+                return (sub_buckets + index % sub_buckets) << shift;
+            }
+
+            static std::uint64_t width(std::size_t index) {
+                return index < sub_buckets ? 1 : std::uint64_t(1) << (index / sub_buckets - 1);
+            }
+    };
+
+    /**
+     * Invocation timing for one listener.
+     */
+    struct listener_stats {
+        subscription handle;
+        std::uintptr_t address;
+        std::uint64_t calls;
+        std::uint64_t total_ns;
+    };
+
+    /**
+     * A point in time copy of one signal type's metrics, returned by <code>dispatcher::statistics()</code>. 
+     * Latencies cover the whole dispatch (every listener), in nanoseconds. <code>name</code> is the type's
+     * demangled name where the compiler supports it, and stays valid as long as the dispatcher.
+     *
+     * A type's dispatches are counted under the type itself, and under each base type whose listeners they
+     * were routed to (see <code>signal_bases</code>), so a base's count includes its derived types'.
+     */
+    struct signal_stats {
+        std::size_t id;
+        const char* name;
+        std::uint64_t dispatches;
+        std::size_t listeners;
+        std::uint64_t total_ns;
+        std::uint64_t p50_ns;
+        std::uint64_t p99_ns;
+        std::uint64_t p999_ns;
+        std::uint64_t max_ns;
+        std::vector<listener_stats> per_listener;
+    };
+
+    /**
+     * Running metrics for one signal type, kept by the dispatcher when instrumentation is enabled.
+     */
+    struct signal_metrics {
+        std::string name;
+        latency_histogram latency;
+    };
+
+    /**
+     * The readable name of <code>type</code>: demangled where the ABI provides it, otherwise as the compiler 
+     * names it.
+     */
+    inline std::string type_name(const std::type_info& type) {
+#ifdef DISPATCH_DEMANGLE
+        int status = 0;
+        char* demangled = abi::__cxa_demangle(type.name(), nullptr, nullptr, &status);
+        if (status == 0 && demangled) {
+            std::string name(demangled);
+            std::free(demangled);
+            return name;
+        }
+#endif
+        return type.name();
+    }
+
+    typedef std::chrono::steady_clock instrumentation_clock;
+
+    inline std::uint64_t elapsed_ns(instrumentation_clock::time_point start) {
+        return static_cast<std::uint64_t>(
+            std::chrono::duration_cast<std::chrono::nanoseconds>(instrumentation_clock::now() - start).count());
+    }
+
+#ifdef DISPATCH_INSTRUMENTATION
+
+    /**
+     * Times a dispatch into a <code>signal_metrics</code>, if there is one.
+     */
+    class dispatch_timer {
+        public:
+            explicit dispatch_timer(signal_metrics* metrics) 
+                : m_metrics(metrics), 
+                  m_start(metrics ? instrumentation_clock::now() : instrumentation_clock::time_point()) 
+            { }
+
+            ~dispatch_timer() {
+                if (m_metrics) {
+                    m_metrics->latency.record(elapsed_ns(m_start));
+                }
+            }
+
+        private:
+            signal_metrics* m_metrics;
+            instrumentation_clock::time_point m_start;
+    };
+
+#else
+
+    /**
+     * Instrumentation is compiled out: the timer is an empty object the optimizer removes entirely.
+     */
+    class dispatch_timer {
+        public:
+            explicit dispatch_timer(signal_metrics*) { }
+    };
+
+#endif
+
+};
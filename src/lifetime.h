@@ -0,0 +1,200 @@
+////////////////////////////////////////////////////////////////////////////////
+//
+// The MIT License (MIT)
+// 
+// Copyright (c) 2015 Matt Bolt
+// 
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+// 
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+// 
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+////////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include <cstddef>
+#include <memory>
+#include <utility>
+
+
+namespace dispatch {
+
+    class lifetime;
+
+    /**
+     * A lifetime token to embed in a subscriber. Listeners tracked by it (see <code>track</code>) stop being
+     * invoked once it's destroyed, and are pruned from their lists later on. Checking the token is a plain, 
+     * non-atomic load, so a tracker must be destroyed on the thread that dispatches to its listeners. For 
+     * subscribers shared across threads, track a <code>std::shared_ptr</code> instead.
+     *
+     * Copies of a subscriber get a fresh token, they don't inherit its subscriptions.
+     */
+    class tracker {
+        public:
+            //----------------------------------
+            //  constructor
+            //----------------------------------
+
+            tracker() 
+                : m_state(new state()) 
+            { }
+
+            tracker(const tracker&) 
+                : m_state(new state()) 
+            { }
+
+            //----------------------------------
+            //  destructor
+            //----------------------------------
+
+            ~tracker() {
+                m_state->alive = false;
+                release(m_state);
+            }
+
+            //----------------------------------
+            //  operators
+            //----------------------------------
+
+            tracker& operator=(const tracker&) {
+                return *this;
+            }
+
+        private:
+            friend class lifetime;
+
+            /**
+             * Shared by the tracker and every listener it tracks. The last one out frees it.
+             */
+            struct state {
+                bool alive;
+                std::size_t references;
+
+                state() : alive(true), references(1) { }
+            };
+
+            state* m_state;
+
+            static void release(state* s) {
+                if (--s->references == 0) {
+                    delete s;
+                }
+            }
+    };
+
+    /**
+     * What keeps a listener alive: nothing (untracked), a <code>tracker</code>, or a <code>std::weak_ptr</code>
+     * to its owner. Checking a weak owner is a relaxed load of its use count, never a <code>lock()</code>.
+     */
+    class lifetime {
+        public:
+            //----------------------------------
+            //  constructor
+            //----------------------------------
+
+            lifetime() 
+                : m_token(nullptr), 
+                  m_weak(false) 
+            { }
+
+            explicit lifetime(const tracker& token) 
+                : m_token(token.m_state), 
+                  m_weak(false) 
+            { 
+                ++m_token->references;
+            }
+
+            template<class T>
+            explicit lifetime(const std::weak_ptr<T>& owner) 
+                : m_token(nullptr), 
+                  m_owner(owner), 
+                  m_weak(true) 
+            { }
+
+            template<class T>
+            explicit lifetime(const std::shared_ptr<T>& owner) 
+                : m_token(nullptr), 
+                  m_owner(owner), 
+                  m_weak(true) 
+            { }
+
+            lifetime(const lifetime& other) 
+                : m_token(other.m_token), 
+                  m_owner(other.m_owner), 
+                  m_weak(other.m_weak) 
+            { 
+                if (m_token) {
+                    ++m_token->references;
+                }
+            }
+
+            lifetime(lifetime&& other) noexcept 
+                : m_token(other.m_token), 
+                  m_owner(std::move(other.m_owner)), 
+                  m_weak(other.m_weak) 
+            { 
+                other.m_token = nullptr;
+                other.m_weak = false;
+            }
+
+            //----------------------------------
+            //  destructor
+            //----------------------------------
+
+            ~lifetime() {
+                if (m_token) {
+                    tracker::release(m_token);
+                }
+            }
+
+            //----------------------------------
+            //  operators
+            //----------------------------------
+
+            lifetime& operator=(lifetime other) noexcept {
+                std::swap(m_token, other.m_token);
+                m_owner.swap(other.m_owner);
+                std::swap(m_weak, other.m_weak);
+                return *this;
+            }
+
+            //----------------------------------
+            //  methods
+            //----------------------------------
+
+            bool tracked() const {
+                return m_token || m_weak;
+            }
+
+            /**
+             * Untracked lifetimes are always alive.
+             */
+            bool alive() const {
+                if (m_token) {
+                    return m_token->alive;
+                }
+
+                return !m_weak || !m_owner.expired();
+            }
+
+        private:
+            tracker::state* m_token;
+            std::weak_ptr<void> m_owner;
+            bool m_weak;
+    };
+
+};
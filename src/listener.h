@@ -29,31 +29,76 @@
 #include <typeindex>
 #include "handler.h"
 #include "signal.h"
+#include "delegate.h"
 #include "helpers.h"
+#include "lifetime.h"
 
 
 namespace dispatch {
-  
+
+    /**
+     * Tag used to key the batch listeners of <code>T</code> under their own <code>signal_id</code>.
+     */
+    template<class T> struct batch_of { };
+
+    /**
+     * The delegate type for a batch listener of <code>T</code>.
+     */
+    template<class T> 
+    using batch_delegate = delegate<void(const T*, std::size_t)>;
+
+    /**
+     * Determines whether or not a callable is a batch listener, ie: <code>void(const T*, std::size_t)</code> where
+     * <code>T</code> implements signal.
+     */
+    template<class F, bool B = func_traits<F>::arg_count == 2> struct is_batch_listener 
+        : std::false_type { };
+
+    template<class F> struct is_batch_listener<F, true> 
+        : std::integral_constant<
+            bool,
+            std::is_pointer<typename std::decay<function_param_at<F, 0>>::type>::value
+                && std::is_base_of<signal, full_decay_t<function_param_at<F, 0>>>::value
+                && std::is_integral<typename std::decay<function_param_at<F, 1>>::type>::value> { };
+
+    /**
+     * Resolves the signal type a callable listens for (<code>type</code>) and the type its <code>signal_id</code> 
+     * is keyed on (<code>key</code>), which differ for batch listeners.
+     */
+    template<class F, bool B = is_batch_listener<F>::value> struct listener_signal {
+        typedef typename std::decay<function_param_at<F, 0>>::type type;
+        typedef type key;
+    };
+
+    template<class F> struct listener_signal<F, true> {
+        typedef typename std::remove_cv<full_decay_t<function_param_at<F, 0>>>::type type;
+        typedef batch_of<type> key;
+    };
+
     /**
      * The listener class is the global wrapper for all listening function types awaiting signals. These
      * types include <code>std::function</code>, lambdas, <code>std::bind</code>, and C-Style function pointers.
      * The key to comparison is by memory address, so each of the type's addresses must be maintained through the
      * listening process. These addresses can be passed in as a ctor parameter or we can use the <code>pointer_memory</code>
      * tool to identify it.
+     *
+     * <code>T</code> is always the unqualified signal type. Every listener receives the signal as <code>const T&</code>
+     * regardless of its declared parameter, so a dispatch never copies the payload on behalf of the dispatcher.
      */
     template<class T> 
     struct listener : public handler {
         static_assert(std::is_base_of<signal, full_decay_t<T>>::value, "listener<T>: T instance must implement signal.");
+        static_assert(std::is_same<T, typename std::decay<T>::type>::value, "listener<T>: T must be an unqualified signal type.");
 
         template<class E>
         listener(const E& callable, std::uintptr_t addr)
-            : m_callable(callable),
+            : m_callable(adapt(callable)),
               m_addr(addr)
         { }
         
         template<class E>
         listener(const E& callable) 
-            : m_callable(callable),
+            : m_callable(adapt(callable)),
               m_addr(pointer_memory<E>::address_for(callable))
         { }
 
@@ -69,9 +114,141 @@ namespace dispatch {
             return m_addr == addr;
         }
 
+        /**
+         * The identity used for address based removal.
+         */
+        inline std::uintptr_t address() const {
+            return m_addr;
+        }
+
+        inline delegate<void(const T&)>& callable() {
+            return m_callable;
+        }
+
         private:
-            std::function<void(T)> m_callable;
+            delegate<void(const T&)> m_callable;
             std::uintptr_t m_addr;
+
+            static const delegate<void(const T&)>& adapt(const delegate<void(const T&)>& callable) {
+                return callable;
+            }
+
+            template<class E>
+            static delegate<void(const T&)> adapt(const E& callable) {
+                typedef function_param_at<E, 0> P;
+                return [callable](const T& s) mutable { callable(signal_forward<P>::apply(s)); };
+            }
     };
 
+    /**
+     * A callable paired with the priority to subscribe it at, for use with <code>dispatcher::operator+=</code>. 
+     * Holds a reference, so the callable's address is still the one used for removal.
+     */
+    template<class F> 
+    struct prioritized {
+        const F& callable;
+        int priority;
+    };
+
+    /**
+     * <code>d += with_priority(10, callable)</code> subscribes ahead of every listener with a lower priority. 
+     * Listeners added with <code>+=</code> alone have priority 0.
+     */
+    template<class F>
+    inline prioritized<F> with_priority(int priority, const F& callable) {
+        return prioritized<F>{ callable, priority };
+    }
+
+    /**
+     * A callable paired with the key to subscribe it under, for use with <code>dispatcher::operator+=</code>.
+     */
+    template<class K, class F> 
+    struct keyed {
+        K key;
+        const F& callable;
+    };
+
+    /**
+     * <code>d += for_key(id, callable)</code> subscribes a keyed listener. See <code>dispatcher::add_keyed</code>.
+     */
+    template<class K, class F>
+    inline keyed<K, F> for_key(const K& key, const F& callable) {
+        return keyed<K, F>{ key, callable };
+    }
+
+    /**
+     * A listener paired with the lifetime of its owner, for use with <code>dispatcher::operator+=</code>. See 
+     * <code>track</code>.
+     */
+    template<class T> 
+    struct tracked {
+        listener<T> target;
+        lifetime life;
+    };
+
+    /**
+     * <code>d += track(owner, callable)</code> subscribes a listener which is only invoked while <code>owner</code> 
+     * (a <code>tracker</code>, <code>std::shared_ptr</code> or <code>std::weak_ptr</code>) is alive. The callable's 
+     * address is still the one used for removal.
+     */
+    template<class O, class F>
+    inline tracked<typename std::decay<function_param_at<F, 0>>::type> track(const O& owner, const F& callable) {
+        typedef typename std::decay<function_param_at<F, 0>>::type E;
+
+        return tracked<E>{ 
+            listener<E>(function_wrapper<F>::wrap(callable), pointer_memory<F>::address_for(callable)), 
+            lifetime(owner) 
+        };
+    }
+
+    /**
+     * <code>d += track(object, &C::method)</code> subscribes a member function of a shared object without keeping
+     * it alive. The object's address is used for removal.
+     */
+    template<class C, class P>
+    inline tracked<typename std::decay<P>::type> track(const std::shared_ptr<C>& object, void (C::*method)(P)) {
+        typedef typename std::decay<P>::type E;
+
+        C* target = object.get();
+        return tracked<E>{ 
+            listener<E>([target, method](const E& s) { (target->*method)(signal_forward<P>::apply(s)); }, reinterpret_cast<std::uintptr_t>(target)), 
+            lifetime(object) 
+        };
+    }
+
+    template<class C, class P>
+    inline tracked<typename std::decay<P>::type> track(const std::shared_ptr<C>& object, void (C::*method)(P) const) {
+        typedef typename std::decay<P>::type E;
+
+        const C* target = object.get();
+        return tracked<E>{ 
+            listener<E>([target, method](const E& s) { (target->*method)(signal_forward<P>::apply(s)); }, reinterpret_cast<std::uintptr_t>(target)), 
+            lifetime(object) 
+        };
+    }
+
+    /**
+     * <code>d += track(m_tracker, this, &C::method)</code> subscribes a member function of an object which embeds 
+     * <code>tracker</code>. The object's address is used for removal.
+     */
+    template<class C, class P>
+    inline tracked<typename std::decay<P>::type> track(const tracker& token, C* object, void (C::*method)(P)) {
+        typedef typename std::decay<P>::type E;
+
+        return tracked<E>{ 
+            listener<E>([object, method](const E& s) { (object->*method)(signal_forward<P>::apply(s)); }, reinterpret_cast<std::uintptr_t>(object)), 
+            lifetime(token) 
+        };
+    }
+
+    template<class C, class P>
+    inline tracked<typename std::decay<P>::type> track(const tracker& token, const C* object, void (C::*method)(P) const) {
+        typedef typename std::decay<P>::type E;
+
+        return tracked<E>{ 
+            listener<E>([object, method](const E& s) { (object->*method)(signal_forward<P>::apply(s)); }, reinterpret_cast<std::uintptr_t>(object)), 
+            lifetime(token) 
+        };
+    }
+
 };
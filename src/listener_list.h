@@ -0,0 +1,759 @@
+////////////////////////////////////////////////////////////////////////////////
+//
+// The MIT License (MIT)
+// 
+// Copyright (c) 2015 Matt Bolt
+// 
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+// 
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+// 
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+////////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include <vector>
+#include <algorithm>
+#include <cstdint>
+#include <functional>
+#include <utility>
+#include "delegate.h"
+#include "dispatch_context.h"
+#include "lifetime.h"
+#include "subscription.h"
+#include "instrumentation.h"
+
+
+namespace dispatch {
+
+    /**
+     * Contiguous listener storage for a single signal type, kept as a structure of arrays: invoke thunks, 
+     * inline target storage (the thunk's context) and identity addresses each live in their own packed array. 
+     * Dispatch is a linear sweep over the first two, and the addresses are only read when removing.
+     *
+     * The list itself is type erased so a dispatcher can keep one per signal id. Thunks are stored as generic
+     * function pointers and cast back to <code>delegate<Sig>::invoker_t</code> by the typed methods, so every 
+     * method must be called with the same signature (<code>void(const T&)</code> for the typed shorthands).
+     *
+     * Every listener also owns a stable slot, which maps back to its current position and carries a generation
+     * that is bumped when the slot is released. Slots back <code>subscription</code> handles, so removal by 
+     * handle is O(1).
+     *
+     * Removal tombstones the position in place: the thunk becomes a no-op and the address is cleared. Tombstones 
+     * are compacted away (a stable, in-place erase which never reallocates) once they outnumber the live 
+     * listeners, so add/remove churn stays amortized O(1).
+     *
+     * Listeners are kept sorted by descending priority, ties in insertion order. The order is fixed when a 
+     * listener is added, so dispatching never sorts.
+     *
+     * Listeners may be tracked by a <code>lifetime</code>. Dispatching skips dead ones, and they're tombstoned
+     * all at once by <code>prune</code>, which runs after any dispatch that ran into one. Lists without tracked 
+     * listeners don't check lifetimes at all.
+     *
+     * Listeners may add and remove listeners, and dispatch again, while the list is being dispatched. Removal 
+     * only tombstones, which is safe mid-sweep. Listeners added while any dispatch of the list is running are 
+     * queued (their handle is valid right away), and compaction and pruning wait too; all of it is applied when
+     * the outermost dispatch returns. A listener added during a dispatch doesn't receive that signal.
+     */
+    class listener_list {
+        public:
+            //----------------------------------
+            //  constructor
+            //----------------------------------
+
+            listener_list() 
+                : m_skip(nullptr), 
+                  m_free_slot(npos), 
+                  m_tombstones(0),
+                  m_tracked(0),
+                  m_stale(false),
+                  m_depth(0),
+                  m_deferred_live(0),
+                  m_unsettled(false)
+            { }
+
+            //----------------------------------
+            //  methods
+            //----------------------------------
+
+            /**
+             * Adds a listener after every listener of the same or higher <code>priority</code> and returns its 
+             * slot and generation. Adding at or below the lowest priority is an append.
+             */
+            template<class Sig>
+            std::pair<std::uint32_t, std::uint32_t> push_back(delegate<Sig> callable, std::uintptr_t addr, int priority = 0, lifetime life = lifetime()) {
+                m_skip = reinterpret_cast<thunk_t>(&skip<Sig>::invoke);
+
+                if (m_depth > 0) {
+                    std::uint32_t slot = acquire_slot(deferred_bit | static_cast<std::uint32_t>(m_deferred.size()));
+                    m_deferred.push_back(deferred_add{ 
+                        reinterpret_cast<thunk_t>(callable.invoker()), callable.release(), addr, slot, priority, std::move(life) 
+                    });
+                    ++m_deferred_live;
+                    m_unsettled = true;
+
+                    return std::make_pair(slot, m_slots[slot].generation);
+                }
+
+                if (m_stale) {
+                    prune();
+                }
+
+                thunk_t thunk = reinterpret_cast<thunk_t>(callable.invoker());
+                std::uint32_t slot = acquire_slot(npos);
+                place(thunk, callable.release(), addr, slot, priority, std::move(life));
+
+                return std::make_pair(slot, m_slots[slot].generation);
+            }
+
+            /**
+             * Tombstones the first listener registered with <code>addr</code>. Returns false if there wasn't one.
+             */
+            bool remove(std::uintptr_t addr) {
+                for (std::size_t i = 0; i < m_addresses.size(); ++i) {
+                    if (m_addresses[i] == addr) {
+                        erase_at(i);
+                        return true;
+                    }
+                }
+
+                for (deferred_add& add : m_deferred) {
+                    if (add.address == addr) {
+                        cancel(add);
+                        return true;
+                    }
+                }
+
+                return false;
+            }
+
+            /**
+             * Tombstones the listener in <code>slot</code> if it's still on <code>generation</code>.
+             */
+            bool remove(std::uint32_t slot, std::uint32_t generation) {
+                if (slot >= m_slots.size() || m_slots[slot].generation != generation || m_slots[slot].position == npos) {
+                    return false;
+                }
+
+                std::uint32_t position = m_slots[slot].position;
+                if (position & deferred_bit) {
+                    cancel(m_deferred[position & ~deferred_bit]);
+                } else {
+                    erase_at(position);
+                }
+
+                return true;
+            }
+
+            /**
+             * Tombstones every tracked listener whose owner is gone.
+             */
+            void prune() {
+                m_stale = false;
+                if (m_tracked == 0) {
+                    return;
+                }
+
+                for (std::size_t i = 0; i < m_lifetimes.size(); ++i) {
+                    if (m_addresses[i] != 0 && !m_lifetimes[i].alive()) {
+                        tombstone(i);
+                    }
+                }
+
+                compact_if_sparse();
+            }
+
+            /**
+             * Marks the list as being dispatched for its lifetime. The outermost scope applies whatever was
+             * deferred while it was open. The dispatch methods below open their own; one is only needed around 
+             * <code>invoke_range</code> and the ranged <code>dispatch_each</code>, which may run on several 
+             * threads at once and leave it, and <code>mark_stale()</code>, to the caller.
+             */
+            class dispatch_scope {
+                public:
+                    explicit dispatch_scope(listener_list& list) 
+                        : m_list(list) 
+                    { 
+                        ++m_list.m_depth;
+                    }
+
+                    dispatch_scope(const dispatch_scope&) = delete;
+                    dispatch_scope& operator=(const dispatch_scope&) = delete;
+
+                    ~dispatch_scope() {
+                        if (--m_list.m_depth == 0 && (m_list.m_unsettled || m_list.m_stale)) {
+                            m_list.settle();
+                        }
+                    }
+
+                private:
+                    listener_list& m_list;
+            };
+
+            /**
+             * Calls every listener with <code>args</code>. <code>Sig</code> must match the signature the 
+             * listeners were added with.
+             */
+            template<class Sig, class...Args>
+            inline void invoke(const Args&...args) {
+                dispatch_scope scope(*this);
+                if (invoke_range<Sig>(0, m_thunks.size(), args...)) {
+                    mark_stale();
+                }
+            }
+
+            /**
+             * Calls the listeners at positions <code>[begin, end)</code>, where <code>end <= extent()</code>.
+             * Returns whether it skipped an expired listener; the list isn't written to, so the caller passes 
+             * that on to <code>mark_stale()</code>.
+             */
+            template<class Sig, class...Args>
+            inline bool invoke_range(std::size_t begin, std::size_t end, const Args&...args) const {
+                typedef typename delegate<Sig>::invoker_t invoker_t;
+
+                const thunk_t* thunks = m_thunks.data();
+                const delegate_storage* contexts = m_contexts.data();
+                bool stale = false;
+
+                for (std::size_t i = begin; i < end; ++i) {
+                    if (m_tracked != 0 && !alive(i)) {
+                        stale = true;
+                        continue;
+                    }
+#ifdef DISPATCH_INSTRUMENTATION
+                    listener_timer timer(m_timings[i]);
+#endif
+                    reinterpret_cast<invoker_t>(thunks[i])(contexts[i], args...);
+                }
+
+                return stale;
+            }
+
+            /**
+             * Calls every listener with <code>value</code> in priority order, stopping as soon as one of them 
+             * consumes it. <code>frame</code> is the dispatch's frame, pointed at <code>value</code>.
+             */
+            template<class T>
+            inline void dispatch(const T& value, dispatch_context& frame) {
+                typedef typename delegate<void(const T&)>::invoker_t invoker_t;
+
+                dispatch_scope scope(*this);
+
+                const thunk_t* thunks = m_thunks.data();
+                const delegate_storage* contexts = m_contexts.data();
+
+                if (m_tracked == 0) {
+                    for (std::size_t i = 0, end = m_thunks.size(); i < end; ++i) {
+                        if (frame.consumed()) {
+                            return;
+                        }
+#ifdef DISPATCH_INSTRUMENTATION
+                        listener_timer timer(m_timings[i]);
+#endif
+                        reinterpret_cast<invoker_t>(thunks[i])(contexts[i], value);
+                    }
+                    return;
+                }
+
+                for (std::size_t i = 0, end = m_thunks.size(); i < end; ++i) {
+                    if (frame.consumed()) {
+                        return;
+                    }
+                    if (!alive(i)) {
+                        m_stale = true;
+                        continue;
+                    }
+#ifdef DISPATCH_INSTRUMENTATION
+                    listener_timer timer(m_timings[i]);
+#endif
+                    reinterpret_cast<invoker_t>(thunks[i])(contexts[i], value);
+                }
+            }
+
+            /**
+             * Delivers <code>count</code> signals, one at a time, to the listeners at positions <code>[begin, end)</code>.
+             * Each listener sees the whole sequence, in order, before the next listener runs, so its context is 
+             * only loaded once. The thunk is reloaded per signal, so a listener removed part way through the batch
+             * (by itself or anyone else) stops there. Signals <code>frame</code> has as consumed are skipped. 
+             * Returns whether it skipped an expired listener, as <code>invoke_range</code> does.
+             *
+             * The frame is only read, as this may run on several threads at once: listeners can't consume here.
+             */
+            template<class T>
+            inline bool dispatch_each(std::size_t begin, std::size_t end, const T* values, std::size_t count, const dispatch_context& frame) const {
+                typedef typename delegate<void(const T&)>::invoker_t invoker_t;
+
+                bool stale = false;
+
+                for (std::size_t i = begin; i < end; ++i) {
+                    if (m_tracked != 0 && !alive(i)) {
+                        stale = true;
+                        continue;
+                    }
+#ifdef DISPATCH_INSTRUMENTATION
+                    listener_timer timer(m_timings[i]);
+#endif
+                    const delegate_storage& context = m_contexts[i];
+
+                    for (std::size_t j = 0; j < count; ++j) {
+                        if (!frame.consumed(j)) {
+                            reinterpret_cast<invoker_t>(m_thunks[i])(context, values[j]);
+                        }
+                    }
+                }
+
+                return stale;
+            }
+
+            /**
+             * Delivers <code>count</code> signals to every listener in the same order, pointing <code>frame</code> 
+             * at each signal as it's delivered, so a listener that consumes one stops it from reaching the
+             * listeners after it.
+             */
+            template<class T>
+            inline void dispatch_each(const T* values, std::size_t count, dispatch_context& frame) {
+                dispatch_each(values, count, identity<T>, frame);
+            }
+
+            /**
+             * Delivers <code>count</code> signals of a derived type <code>S</code> to listeners of <code>T</code>,
+             * converting each one with <code>cast</code>. Same order as above.
+             */
+            template<class T, class S>
+            inline void dispatch_each(const S* values, std::size_t count, const T* (*cast)(const S*), dispatch_context& frame) {
+                typedef typename delegate<void(const T&)>::invoker_t invoker_t;
+
+                dispatch_scope scope(*this);
+
+                for (std::size_t i = 0; i < m_thunks.size(); ++i) {
+                    if (m_tracked != 0 && !alive(i)) {
+                        m_stale = true;
+                        continue;
+                    }
+#ifdef DISPATCH_INSTRUMENTATION
+                    listener_timer timer(m_timings[i]);
+#endif
+                    const delegate_storage& context = m_contexts[i];
+
+                    for (std::size_t j = 0; j < count; ++j) {
+                        if (!frame.consumed(j)) {
+                            frame.select(j);
+                            reinterpret_cast<invoker_t>(m_thunks[i])(context, *cast(values + j));
+                        }
+                    }
+                }
+            }
+
+            /**
+             * Has expired listeners pruned once the outermost <code>dispatch_scope</code> closes. Call it from 
+             * the thread that opened the scope, after a ranged dispatch reported one.
+             */
+            void mark_stale() {
+                m_stale = true;
+            }
+
+            /**
+             * The number of positions in use, including tombstones. Ranges passed to <code>invoke_range</code>
+             * and <code>dispatch_each</code> are positions.
+             */
+            std::size_t extent() const {
+                return m_thunks.size();
+            }
+
+            /**
+             * The number of live listeners, counting those added during a dispatch that haven't been placed yet.
+             */
+            std::size_t size() const {
+                return m_addresses.size() - m_tombstones + m_deferred_live;
+            }
+
+            bool empty() const {
+                return size() == 0;
+            }
+
+            /**
+             * Whether a dispatch is running over the list.
+             */
+            bool dispatching() const {
+                return m_depth > 0;
+            }
+
+            /**
+             * The heap bytes held by the list, including unused capacity and targets too large to be stored in
+             * place. The state shared with a <code>tracker</code> isn't counted.
+             */
+            std::size_t memory_usage() const {
+                std::size_t bytes = m_thunks.capacity() * sizeof(thunk_t)
+                    + m_contexts.capacity() * sizeof(delegate_storage)
+                    + m_addresses.capacity() * sizeof(std::uintptr_t)
+                    + m_owners.capacity() * sizeof(std::uint32_t)
+                    + m_priorities.capacity() * sizeof(int)
+                    + m_slots.capacity() * sizeof(slot_entry)
+                    + m_lifetimes.capacity() * sizeof(lifetime)
+                    + m_deferred.capacity() * sizeof(deferred_add)
+                    + m_released.capacity() * sizeof(std::size_t);
+#ifdef DISPATCH_INSTRUMENTATION
+                bytes += m_timings.capacity() * sizeof(listener_timing);
+#endif
+
+                for (const delegate_storage& context : m_contexts) {
+                    bytes += context.heap_bytes();
+                }
+                for (const deferred_add& add : m_deferred) {
+                    bytes += add.context.heap_bytes();
+                }
+
+                return bytes;
+            }
+
+#ifdef DISPATCH_INSTRUMENTATION
+            /**
+             * Invocation timings for every live listener, tagged with the subscription for signal id <code>id</code>.
+             */
+            std::vector<listener_stats> statistics(std::uint32_t id) const {
+                std::vector<listener_stats> result;
+                for (std::size_t i = 0; i < m_addresses.size(); ++i) {
+                    if (m_addresses[i] == 0) {
+                        continue;
+                    }
+
+                    const slot_entry& slot = m_slots[m_owners[i]];
+                    listener_stats stats = { 
+                        subscription(id, m_owners[i], slot.generation), 
+                        m_addresses[i], 
+                        m_timings[i].calls, 
+                        m_timings[i].total_ns 
+                    };
+                    result.push_back(stats);
+                }
+
+                return result;
+            }
+#endif
+
+        private:
+            typedef void (*thunk_t)();
+
+            static constexpr std::uint32_t npos = 0xFFFFFFFF;
+
+            /**
+             * Set in a slot's position while its listener is waiting in <code>m_deferred</code>; the rest is 
+             * the index there.
+             */
+            static constexpr std::uint32_t deferred_bit = 0x80000000;
+
+            /**
+             * A live slot holds the position of its listener. A released slot holds <code>npos</code> and links
+             * to the next free slot.
+             */
+            struct slot_entry {
+                std::uint32_t position;
+                std::uint32_t generation;
+                std::uint32_t next_free;
+            };
+
+            std::vector<thunk_t> m_thunks;
+            std::vector<delegate_storage> m_contexts;
+            std::vector<std::uintptr_t> m_addresses;
+            std::vector<std::uint32_t> m_owners;
+            std::vector<int> m_priorities;
+            std::vector<slot_entry> m_slots;
+            thunk_t m_skip;
+            std::uint32_t m_free_slot;
+            std::size_t m_tombstones;
+
+            /**
+             * Per position lifetimes. Left empty until the first tracked listener is added.
+             */
+            std::vector<lifetime> m_lifetimes;
+            std::size_t m_tracked;
+            bool m_stale;
+
+            /**
+             * A listener added during a dispatch, placed once the outermost dispatch returns. Cancelled ones 
+             * have a zero address.
+             */
+            struct deferred_add {
+                thunk_t thunk;
+                delegate_storage context;
+                std::uintptr_t address;
+                std::uint32_t slot;
+                int priority;
+                lifetime life;
+            };
+
+            std::vector<deferred_add> m_deferred;
+            std::uint32_t m_depth;
+            std::size_t m_deferred_live;
+
+            /**
+             * Positions tombstoned during a dispatch. Their contexts may still be running, so they're released 
+             * once the outermost dispatch returns.
+             */
+            std::vector<std::size_t> m_released;
+
+            /**
+             * Whether anything was deferred since the last settle.
+             */
+            bool m_unsettled;
+
+#ifdef DISPATCH_INSTRUMENTATION
+            /**
+             * Per position invocation timing. A position is only ever run by one thread at a time (parallel
+             * fan-out hands out disjoint ranges), so these are plain counters.
+             */
+            struct listener_timing {
+                std::uint64_t calls;
+                std::uint64_t total_ns;
+
+                listener_timing() : calls(0), total_ns(0) { }
+            };
+
+            struct listener_timer {
+                listener_timing& timing;
+                instrumentation_clock::time_point start;
+
+                explicit listener_timer(listener_timing& _timing) 
+                    : timing(_timing), 
+                      start(instrumentation_clock::now()) 
+                { }
+
+                ~listener_timer() {
+                    ++timing.calls;
+                    timing.total_ns += elapsed_ns(start);
+                }
+            };
+
+            mutable std::vector<listener_timing> m_timings;
+#endif
+
+            std::uint32_t acquire_slot(std::uint32_t position) {
+                if (m_free_slot != npos) {
+                    std::uint32_t slot = m_free_slot;
+                    m_free_slot = m_slots[slot].next_free;
+                    m_slots[slot].position = position;
+                    return slot;
+                }
+
+                m_slots.push_back(slot_entry{ position, 1, npos });
+                return static_cast<std::uint32_t>(m_slots.size() - 1);
+            }
+
+            /**
+             * The position after the last listener with a priority of at least <code>priority</code>.
+             */
+            std::size_t sorted_position(int priority) const {
+                return std::upper_bound(m_priorities.begin(), m_priorities.end(), priority, std::greater<int>()) - m_priorities.begin();
+            }
+
+            /**
+             * Inserts a listener after every listener of the same or higher <code>priority</code>, for an already
+             * acquired <code>slot</code>. An insert before the end shifts the listeners after it and updates their 
+             * slots. Tombstones are shifted too, but their slots may already belong to someone else, so they're 
+             * skipped.
+             */
+            void place(thunk_t thunk, delegate_storage context, std::uintptr_t addr, std::uint32_t slot, int priority, lifetime life) {
+                std::size_t position = m_thunks.size();
+                if (!m_priorities.empty() && priority > m_priorities.back()) {
+                    position = sorted_position(priority);
+                }
+
+                if (life.tracked()) {
+                    if (m_lifetimes.empty()) {
+                        m_lifetimes.resize(m_thunks.size());
+                    }
+                    ++m_tracked;
+                }
+
+                m_thunks.insert(m_thunks.begin() + position, thunk);
+                m_contexts.insert(m_contexts.begin() + position, std::move(context));
+                m_addresses.insert(m_addresses.begin() + position, addr);
+                m_owners.insert(m_owners.begin() + position, slot);
+                m_priorities.insert(m_priorities.begin() + position, priority);
+                if (!m_lifetimes.empty() || life.tracked()) {
+                    m_lifetimes.insert(m_lifetimes.begin() + position, std::move(life));
+                }
+#ifdef DISPATCH_INSTRUMENTATION
+                m_timings.insert(m_timings.begin() + position, listener_timing());
+#endif
+
+                m_slots[slot].position = static_cast<std::uint32_t>(position);
+                for (std::size_t i = position + 1; i < m_addresses.size(); ++i) {
+                    if (m_addresses[i] != 0) {
+                        m_slots[m_owners[i]].position = static_cast<std::uint32_t>(i);
+                    }
+                }
+            }
+
+            /**
+             * Applies everything deferred by the dispatches that just finished: releases the contexts of removed
+             * listeners, places queued listeners, in the order they were added, then prunes and compacts.
+             */
+            void settle() {
+                m_unsettled = false;
+
+                for (std::size_t i = 0; i < m_released.size(); ++i) {
+                    m_contexts[m_released[i]].reset();
+                }
+                m_released.clear();
+
+                for (std::size_t i = 0; i < m_deferred.size(); ++i) {
+                    deferred_add& add = m_deferred[i];
+                    if (add.address != 0) {
+                        place(add.thunk, std::move(add.context), add.address, add.slot, add.priority, std::move(add.life));
+                    }
+                }
+                m_deferred.clear();
+                m_deferred_live = 0;
+
+                if (m_stale) {
+                    prune();
+                } else {
+                    compact_if_sparse();
+                }
+            }
+
+            /**
+             * Drops a listener that was added during a dispatch before it was placed.
+             */
+            void cancel(deferred_add& add) {
+                release_slot(add.slot);
+                add.address = 0;
+                add.context.reset();
+                add.life = lifetime();
+                --m_deferred_live;
+            }
+
+            void release_slot(std::uint32_t owner) {
+                slot_entry& slot = m_slots[owner];
+                slot.position = npos;
+                slot.next_free = m_free_slot;
+                m_free_slot = owner;
+                if (++slot.generation == 0) {
+                    slot.generation = 1;
+                }
+            }
+
+            void erase_at(std::size_t position) {
+                tombstone(position);
+                compact_if_sparse();
+            }
+
+            void tombstone(std::size_t position) {
+                release_slot(m_owners[position]);
+
+                m_thunks[position] = m_skip;
+                m_addresses[position] = 0;
+                ++m_tombstones;
+
+                // The listener's captures go now, not at compaction. A dispatch may be running it, though.
+                if (m_depth == 0) {
+                    m_contexts[position].reset();
+                } else {
+                    m_released.push_back(position);
+                    m_unsettled = true;
+                }
+
+                if (!m_lifetimes.empty() && m_lifetimes[position].tracked()) {
+                    m_lifetimes[position] = lifetime();
+                    --m_tracked;
+                }
+            }
+
+            /**
+             * Compacts once tombstones outnumber live listeners, unless a dispatch is running over the list.
+             */
+            void compact_if_sparse() {
+                if (m_depth > 0) {
+                    m_unsettled = true;
+                    return;
+                }
+
+                if (m_tombstones * 2 > m_addresses.size()) {
+                    compact();
+                }
+            }
+
+            /**
+             * Erases all tombstones, preserving the order of the remaining listeners. Moves listeners between 
+             * positions, so only ever called with no dispatch running over the list.
+             */
+            void compact() {
+                std::size_t write = 0;
+                for (std::size_t read = 0; read < m_addresses.size(); ++read) {
+                    if (m_addresses[read] == 0) {
+                        continue;
+                    }
+
+                    if (write != read) {
+                        m_thunks[write] = m_thunks[read];
+                        m_contexts[write] = std::move(m_contexts[read]);
+                        m_addresses[write] = m_addresses[read];
+                        m_owners[write] = m_owners[read];
+                        m_priorities[write] = m_priorities[read];
+                        if (!m_lifetimes.empty()) {
+                            m_lifetimes[write] = std::move(m_lifetimes[read]);
+                        }
+                        m_slots[m_owners[write]].position = static_cast<std::uint32_t>(write);
+#ifdef DISPATCH_INSTRUMENTATION
+                        m_timings[write] = m_timings[read];
+#endif
+                    }
+                    ++write;
+                }
+
+                m_thunks.resize(write);
+                m_contexts.resize(write);
+                m_addresses.resize(write);
+                m_owners.resize(write);
+                m_priorities.resize(write);
+                if (m_tracked == 0) {
+                    m_lifetimes.clear();
+                } else {
+                    m_lifetimes.resize(write);
+                }
+#ifdef DISPATCH_INSTRUMENTATION
+                m_timings.resize(write);
+#endif
+                m_tombstones = 0;
+            }
+
+            /**
+             * Whether the listener at <code>position</code> may still be invoked. Only reads, so ranged dispatches
+             * on several threads can share it; finding a dead one is reported back through <code>m_stale</code>
+             * or <code>mark_stale()</code> by the caller.
+             */
+            bool alive(std::size_t position) const {
+                return position >= m_lifetimes.size() || m_lifetimes[position].alive();
+            }
+
+            /**
+             * The cast for <code>dispatch_each</code> when the signals are already of the listeners' type.
+             */
+            template<class T>
+            static const T* identity(const T* value) {
+                return value;
+            }
+
+            template<class Sig> struct skip;
+
+            template<class R, class...Args> struct skip<R(Args...)> {
+                static R invoke(const delegate_storage&, Args...) { return R(); }
+            };
+    };
+
+};
@@ -0,0 +1,282 @@
+////////////////////////////////////////////////////////////////////////////////
+//
+// The MIT License (MIT)
+// 
+// Copyright (c) 2015 Matt Bolt
+// 
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+// 
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+// 
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+////////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <limits>
+#include <mutex>
+#include <thread>
+#include <type_traits>
+#include <utility>
+#include <vector>
+#include "delegate.h"
+#include "ring_buffer.h"
+#include "signal.h"
+#include "signal_pool.h"
+#include "dispatcher.h"
+#include "concurrent_dispatcher.h"
+
+
+namespace dispatch {
+
+    /**
+     * Queues signals for later delivery through a target dispatcher. <code>post</code> copies the signal into
+     * a bounded lock-free ring and returns right away, and the queue is drained either by worker threads
+     * (<code>start</code>) or by calling <code>pump</code> from your own loop. Queued signals run through the
+     * target's existing listener lists, in order per producer.
+     *
+     * Queued signals live in blocks from <code>signal_pool</code> and the ring cell only holds the pointer, so 
+     * once the pool has warmed up posting doesn't allocate. A signal goes back to the pool as soon as its
+     * last listener returns, or when it's dropped by the overflow policy.
+     *
+     * Workers call <code>D::dispatch</code> concurrently with whichever thread subscribes, so with more than one 
+     * worker, or when listeners change while workers run, <code>D</code> should be a <code>concurrent_dispatcher</code>.
+     * Listeners invoked from workers must not throw.
+     */
+    template<class D>
+    class basic_queued_dispatcher {
+        public:
+            //----------------------------------
+            //  constructor
+            //----------------------------------
+
+            basic_queued_dispatcher(D& target, std::size_t capacity, overflow_policy policy = overflow_policy::block)
+                : m_target(target),
+                  m_queue(capacity),
+                  m_policy(policy),
+                  m_stopping(false),
+                  m_dropped(0),
+                  m_waiting(0)
+            { }
+
+            basic_queued_dispatcher(const basic_queued_dispatcher&) = delete;
+            basic_queued_dispatcher& operator=(const basic_queued_dispatcher&) = delete;
+
+            //----------------------------------
+            //  destructor
+            //----------------------------------
+
+            /**
+             * Stops any workers after they drain the queue.
+             */
+            ~basic_queued_dispatcher() {
+                stop();
+            }
+
+            //----------------------------------
+            //  methods
+            //----------------------------------
+
+            /**
+             * Queues a copy of <code>value</code>. Returns false if the signal was dropped because the queue 
+             * was full under <code>overflow_policy::drop_newest</code>.
+             */
+            template<class T>
+            bool post(T&& value) {
+                return emplace<typename std::decay<T>::type>(std::forward<T>(value));
+            }
+
+            /**
+             * Constructs a <code>T</code> from <code>args</code> directly in a pooled block and queues it, 
+             * skipping the copy <code>post</code> makes. Returns false if the signal was dropped.
+             */
+            template<class T, class...Args>
+            bool emplace(Args&&...args) {
+                static_assert(std::is_base_of<signal, T>::value, "T type must implement signal.");
+
+                item deliver(pooled_delivery<T>{ make_pooled<T>(std::forward<Args>(args)...) });
+                return enqueue(deliver);
+            }
+
+            /**
+             * Delivers up to <code>max</code> queued signals on the calling thread and returns how many were 
+             * delivered.
+             */
+            std::size_t pump(std::size_t max = std::numeric_limits<std::size_t>::max()) {
+                std::size_t delivered = 0;
+
+                item next;
+                while (delivered < max && m_queue.try_pop(next)) {
+                    wake_producers();
+                    next(m_target);
+                    next = item();
+                    ++delivered;
+                }
+
+                return delivered;
+            }
+
+            /**
+             * Starts <code>count</code> worker threads which drain the queue until <code>stop</code> is called.
+             */
+            void start(std::size_t count = 1) {
+                m_stopping.store(false);
+                for (std::size_t i = 0; i < count; ++i) {
+                    m_workers.emplace_back(&basic_queued_dispatcher::run, this);
+                }
+            }
+
+            /**
+             * Lets the workers finish whatever is queued, then joins them.
+             */
+            void stop() {
+                {
+                    std::lock_guard<std::mutex> lock(m_lock);
+                    m_stopping.store(true);
+                }
+                m_wake.notify_all();
+
+                for (std::thread& worker : m_workers) {
+                    worker.join();
+                }
+                m_workers.clear();
+            }
+
+            /**
+             * The number of signals discarded by the overflow policy so far.
+             */
+            std::size_t dropped() const {
+                return m_dropped.load(std::memory_order_relaxed);
+            }
+
+            /**
+             * An approximate count of queued signals.
+             */
+            std::size_t size() const {
+                return m_queue.size();
+            }
+
+            D& target() {
+                return m_target;
+            }
+
+        private:
+            typedef unique_delegate<void(D&)> item;
+
+            /**
+             * The queued item for a pooled signal. Destroying the item returns the signal to its pool.
+             */
+            template<class T>
+            struct pooled_delivery {
+                pooled_ptr<T> value;
+
+                void operator()(D& d) const {
+                    d.dispatch(*value);
+                }
+            };
+
+            D& m_target;
+            mpmc_ring<item> m_queue;
+            overflow_policy m_policy;
+            std::vector<std::thread> m_workers;
+
+            std::atomic<bool> m_stopping;
+            std::atomic<std::size_t> m_dropped;
+
+            /**
+             * Workers sleeping on an empty queue and producers blocked on a full one. Only touched on the slow 
+             * path; the fast path just checks <code>m_waiting</code>.
+             */
+            std::mutex m_lock;
+            std::condition_variable m_wake;
+            std::condition_variable m_space;
+            std::atomic<std::size_t> m_waiting;
+
+            bool enqueue(item& deliver) {
+                while (!m_queue.try_push(deliver)) {
+                    switch (m_policy) {
+                        case overflow_policy::drop_newest:
+                            m_dropped.fetch_add(1, std::memory_order_relaxed);
+                            return false;
+
+                        case overflow_policy::drop_oldest: {
+                            item oldest;
+                            if (m_queue.try_pop(oldest)) {
+                                m_dropped.fetch_add(1, std::memory_order_relaxed);
+                            }
+                            break;
+                        }
+
+                        case overflow_policy::block: {
+                            std::unique_lock<std::mutex> lock(m_lock);
+                            m_waiting.fetch_add(1);
+                            m_space.wait(lock, [this]() { return m_queue.size() < m_queue.capacity(); });
+                            m_waiting.fetch_sub(1);
+                            break;
+                        }
+                    }
+                }
+
+                if (has_waiters()) {
+                    std::lock_guard<std::mutex> lock(m_lock);
+                    m_wake.notify_one();
+                }
+
+                return true;
+            }
+
+            void wake_producers() {
+                if (has_waiters()) {
+                    std::lock_guard<std::mutex> lock(m_lock);
+                    m_space.notify_all();
+                }
+            }
+
+            /**
+             * Read-modify-write rather than a plain load, so it orders against the waiter's increment and the
+             * queue index it checks afterwards. Either we see the waiter, or the waiter sees our change.
+             */
+            bool has_waiters() {
+                return m_waiting.fetch_add(0) > 0;
+            }
+
+            void run() {
+                for (;;) {
+                    if (pump(1) > 0) {
+                        continue;
+                    }
+
+                    std::unique_lock<std::mutex> lock(m_lock);
+                    m_waiting.fetch_add(1);
+                    m_wake.wait(lock, [this]() { return !m_queue.empty() || m_stopping.load(); });
+                    m_waiting.fetch_sub(1);
+
+                    if (m_queue.empty() && m_stopping.load()) {
+                        return;
+                    }
+                }
+            }
+    };
+
+    /**
+     * A queued dispatcher over a thread safe target, suitable for any number of workers.
+     */
+    typedef basic_queued_dispatcher<concurrent_dispatcher> queued_dispatcher;
+
+};
@@ -0,0 +1,548 @@
+////////////////////////////////////////////////////////////////////////////////
+//
+// The MIT License (MIT)
+// 
+// Copyright (c) 2015 Matt Bolt
+// 
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+// 
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+// 
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+////////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include "dispatcher.h"
+
+// The log is written and read through mmap, so recording is only available on POSIX systems. 
+// DISPATCH_RECORDING is defined when this header provides it.
+#if defined(__unix__) || defined(__APPLE__)
+#define DISPATCH_RECORDING 1
+#endif
+
+#ifdef DISPATCH_RECORDING
+
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <cstdint>
+#include <cstring>
+#include <limits>
+#include <stdexcept>
+#include <string>
+#include <system_error>
+#include <thread>
+#include <type_traits>
+#include <utility>
+#include <vector>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+
+namespace dispatch {
+
+    /**
+     * Declares how a signal type is written to a recording (see <code>signal_recorder</code>). Signals derive 
+     * from the polymorphic <code>signal</code>, so they can't be copied as raw bytes. Instead, specialize with
+     * a trivially copyable <code>payload</code> type, a non-zero <code>schema</code> id which stays the same 
+     * across builds, a static <code>save</code> returning the payload of a signal, and a static <code>load</code> 
+     * building a signal back from one. Or use <code>DISPATCH_SIGNAL_RECORD</code>.
+     */
+    template<class T> struct signal_record;
+
+    /**
+     * How <code>signal_replayer::replay</code> paces the signals of a recording.
+     */
+    enum class replay_timing {
+        /**
+         * Dispatch every signal as soon as the previous one returns.
+         */
+        fastest,
+
+        /**
+         * Wait until each signal's offset from the first one has elapsed, as it was recorded.
+         */
+        original
+    };
+
+    namespace detail {
+
+        /**
+         * The first bytes of a recording.
+         */
+        struct log_header {
+            char magic[8];
+            std::uint32_t version;
+            std::uint32_t reserved;
+        };
+
+        /**
+         * Precedes every payload. Records start on a multiple of <code>log_alignment</code>, and a zero schema
+         * marks the end of the log, which is where a recording cut short by a crash stops.
+         */
+        struct log_record {
+            std::uint32_t schema;
+            std::uint32_t size;
+            std::uint64_t time;
+        };
+
+        static const char log_magic[8] = { 'd', 'i', 's', 'p', 'a', 't', 'c', 'h' };
+        static const std::uint32_t log_version = 1;
+        static const std::size_t log_alignment = 8;
+
+        inline std::size_t log_padded(std::size_t size) {
+            return (size + log_alignment - 1) & ~(log_alignment - 1);
+        }
+
+        /**
+         * A file descriptor and its mapping, released together.
+         */
+        class mapped_file {
+            public:
+                //----------------------------------
+                //  constructor
+                //----------------------------------
+
+                mapped_file() 
+                    : m_fd(-1), 
+                      m_data(nullptr), 
+                      m_length(0) 
+                { }
+
+                mapped_file(const mapped_file&) = delete;
+                mapped_file& operator=(const mapped_file&) = delete;
+
+                //----------------------------------
+                //  destructor
+                //----------------------------------
+
+                ~mapped_file() {
+                    unmap();
+                    if (m_fd >= 0) {
+                        ::close(m_fd);
+                    }
+                }
+
+                //----------------------------------
+                //  methods
+                //----------------------------------
+
+                void open(const std::string& path, int flags) {
+                    m_fd = ::open(path.c_str(), flags | O_CLOEXEC, 0644);
+                    if (m_fd < 0) {
+                        fail("open");
+                    }
+                }
+
+                /**
+                 * Maps the first <code>length</code> bytes of the file, replacing any previous mapping.
+                 */
+                void map(std::size_t length, int protection) {
+                    unmap();
+                    if (length == 0) {
+                        return;
+                    }
+
+                    void* data = ::mmap(nullptr, length, protection, MAP_SHARED, m_fd, 0);
+                    if (data == MAP_FAILED) {
+                        fail("mmap");
+                    }
+
+                    m_data = static_cast<char*>(data);
+                    m_length = length;
+                }
+
+                void unmap() {
+                    if (m_data) {
+                        ::munmap(m_data, m_length);
+                        m_data = nullptr;
+                        m_length = 0;
+                    }
+                }
+
+                void resize(std::size_t length) {
+                    if (::ftruncate(m_fd, static_cast<off_t>(length)) != 0) {
+                        fail("ftruncate");
+                    }
+                }
+
+                std::size_t file_size() const {
+                    struct stat info;
+                    if (::fstat(m_fd, &info) != 0) {
+                        fail("fstat");
+                    }
+                    return static_cast<std::size_t>(info.st_size);
+                }
+
+                char* data() const {
+                    return m_data;
+                }
+
+                std::size_t length() const {
+                    return m_length;
+                }
+
+            private:
+                int m_fd;
+                char* m_data;
+                std::size_t m_length;
+
+                static void fail(const char* call) {
+                    throw std::system_error(errno, std::generic_category(), std::string("dispatch::mapped_file: ") + call);
+                }
+        };
+
+    };
+
+    /**
+     * Records signals to an append-only binary log, written through a memory mapping that doubles whenever
+     * it fills up. Each record holds the type's schema id, the nanoseconds since the recorder was created, 
+     * and the type's <code>signal_record</code> payload. Appending a record is a copy into the mapping, with 
+     * no system call until the mapping has to grow. Closing trims the file to what was written.
+     *
+     * <code>record</code> taps a dispatcher, adding a listener at the highest priority which appends every
+     * <code>T</code> it dispatches. The recorder isn't thread safe, so its taps must all be on dispatchers 
+     * used from one thread at a time, and the dispatchers must outlive the recorder.
+     */
+    class signal_recorder {
+        public:
+            //----------------------------------
+            //  constructor
+            //----------------------------------
+
+            /**
+             * Creates or truncates the log at <code>path</code>, initially mapping <code>capacity</code> bytes.
+             */
+            explicit signal_recorder(const std::string& path, std::size_t capacity = std::size_t(1) << 20)
+                : m_size(sizeof(detail::log_header)),
+                  m_records(0),
+                  m_start(std::chrono::steady_clock::now()),
+                  m_open(true)
+            {
+                m_file.open(path, O_RDWR | O_CREAT | O_TRUNC);
+                reserve(std::max(capacity, m_size));
+
+                detail::log_header header;
+                std::memcpy(header.magic, detail::log_magic, sizeof(header.magic));
+                header.version = detail::log_version;
+                header.reserved = 0;
+                std::memcpy(m_file.data(), &header, sizeof(header));
+            }
+
+            signal_recorder(const signal_recorder&) = delete;
+            signal_recorder& operator=(const signal_recorder&) = delete;
+
+            //----------------------------------
+            //  destructor
+            //----------------------------------
+
+            ~signal_recorder() {
+                try {
+                    close();
+                } catch (...) {
+                    // The records are in the file already, only trimming its unused tail failed.
+                }
+            }
+
+            //----------------------------------
+            //  methods
+            //----------------------------------
+
+            /**
+             * Records every <code>T</code> dispatched through <code>d</code> until the recorder is closed. If
+             * <code>T</code> is sticky, its latest value is recorded straight away.
+             */
+            template<class T>
+            subscription record(dispatcher& d) {
+                check_open();
+
+                subscription handle = d.add(listener<T>([this](const T& value) { write(value); }, reinterpret_cast<std::uintptr_t>(this)), 
+                    std::numeric_limits<int>::max());
+                m_taps.emplace_back(&d, handle);
+
+                return handle;
+            }
+
+            /**
+             * Appends <code>value</code> to the log.
+             */
+            template<class T>
+            void write(const T& value) {
+                typedef signal_record<T> record;
+                typedef typename record::payload P;
+
+                static_assert(std::is_trivially_copyable<P>::value, "signal_record<T>::payload must be trivially copyable.");
+                static_assert(alignof(P) <= detail::log_alignment, "signal_record<T>::payload is over aligned.");
+                static_assert(record::schema != 0, "signal_record<T>::schema must not be zero.");
+
+                check_open();
+
+                const std::size_t length = sizeof(detail::log_record) + detail::log_padded(sizeof(P));
+                if (m_size + length > m_file.length()) {
+                    reserve(std::max(m_file.length() * 2, m_size + length));
+                }
+
+                detail::log_record header;
+                header.schema = record::schema;
+                header.size = static_cast<std::uint32_t>(sizeof(P));
+                header.time = static_cast<std::uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+                    std::chrono::steady_clock::now() - m_start).count());
+
+                const P& payload = record::save(value);
+
+                // The payload goes in first, so a crash part way through leaves a zero schema behind.
+                char* out = m_file.data() + m_size;
+                std::memcpy(out + sizeof(header), &payload, sizeof(P));
+                std::memcpy(out, &header, sizeof(header));
+
+                m_size += length;
+                ++m_records;
+            }
+
+            /**
+             * Removes the taps, trims the log to the records written and closes it. Does nothing if already 
+             * closed.
+             */
+            void close() {
+                if (!m_open) {
+                    return;
+                }
+                m_open = false;
+
+                for (std::pair<dispatcher*, subscription>& tap : m_taps) {
+                    tap.first->remove(tap.second);
+                }
+                m_taps.clear();
+
+                m_file.unmap();
+                m_file.resize(m_size);
+            }
+
+            /**
+             * The number of records written.
+             */
+            std::size_t records() const {
+                return m_records;
+            }
+
+            /**
+             * The size of the log in bytes, once it's trimmed.
+             */
+            std::size_t bytes() const {
+                return m_size;
+            }
+
+        private:
+            detail::mapped_file m_file;
+            std::size_t m_size;
+            std::size_t m_records;
+            std::chrono::steady_clock::time_point m_start;
+            std::vector<std::pair<dispatcher*, subscription>> m_taps;
+            bool m_open;
+
+            void reserve(std::size_t capacity) {
+                m_file.unmap();
+                m_file.resize(capacity);
+                m_file.map(capacity, PROT_READ | PROT_WRITE);
+            }
+
+            void check_open() const {
+                if (!m_open) {
+                    throw std::logic_error("dispatch::signal_recorder: the recorder is closed");
+                }
+            }
+    };
+
+    /**
+     * Replays a log written by <code>signal_recorder</code> into a dispatcher. The log is mapped read only, 
+     * and each payload is read in place, so replaying copies nothing but the signals themselves, which are 
+     * built on the stack by <code>signal_record&lt;T&gt;::load</code>. Types must be bound before they're 
+     * replayed, and records of unbound types are skipped.
+     */
+    class signal_replayer {
+        public:
+            //----------------------------------
+            //  constructor
+            //----------------------------------
+
+            explicit signal_replayer(const std::string& path)
+                : m_skipped(0)
+            {
+                m_file.open(path, O_RDONLY);
+                m_file.map(m_file.file_size(), PROT_READ);
+
+                detail::log_header header;
+                if (m_file.length() < sizeof(header)) {
+                    throw std::runtime_error("dispatch::signal_replayer: not a signal log");
+                }
+
+                std::memcpy(&header, m_file.data(), sizeof(header));
+                if (std::memcmp(header.magic, detail::log_magic, sizeof(header.magic)) != 0) {
+                    throw std::runtime_error("dispatch::signal_replayer: not a signal log");
+                }
+                if (header.version != detail::log_version) {
+                    throw std::runtime_error("dispatch::signal_replayer: unsupported log version");
+                }
+            }
+
+            signal_replayer(const signal_replayer&) = delete;
+            signal_replayer& operator=(const signal_replayer&) = delete;
+
+            //----------------------------------
+            //  methods
+            //----------------------------------
+
+            /**
+             * Replays the records of <code>T</code>'s schema as <code>T</code>.
+             */
+            template<class T>
+            void bind() {
+                typedef signal_record<T> record;
+
+                binding b = { record::schema, static_cast<std::uint32_t>(sizeof(typename record::payload)), &replay_one<T> };
+
+                auto found = std::lower_bound(m_bindings.begin(), m_bindings.end(), b);
+                if (found != m_bindings.end() && found->schema == b.schema) {
+                    *found = b;
+                } else {
+                    m_bindings.insert(found, b);
+                }
+            }
+
+            /**
+             * Dispatches every record through <code>d</code> in the order they were written, and returns how
+             * many were dispatched. The log ends at a zero schema, or at a record cut off by the end of the file
+             * (a log copied or truncated while it was being written). Throws <code>std::runtime_error</code> if 
+             * a record's size doesn't match the type bound to its schema.
+             */
+            std::size_t replay(dispatcher& d, replay_timing timing = replay_timing::fastest) {
+                typedef std::chrono::steady_clock clock;
+
+                const char* data = m_file.data();
+                const std::size_t length = m_file.length();
+
+                std::size_t dispatched = 0;
+                m_skipped = 0;
+
+                clock::time_point start = clock::now();
+                std::uint64_t first = 0;
+
+                std::size_t offset = sizeof(detail::log_header);
+                while (offset + sizeof(detail::log_record) <= length) {
+                    detail::log_record header;
+                    std::memcpy(&header, data + offset, sizeof(header));
+                    if (header.schema == 0) {
+                        break;
+                    }
+
+                    const char* payload = data + offset + sizeof(header);
+                    if (sizeof(header) + detail::log_padded(header.size) > length - offset) {
+                        break;
+                    }
+                    offset += sizeof(header) + detail::log_padded(header.size);
+
+                    const binding* b = find(header.schema);
+                    if (!b) {
+                        ++m_skipped;
+                        continue;
+                    }
+                    if (b->size != header.size) {
+                        throw std::runtime_error("dispatch::signal_replayer: record size doesn't match its schema");
+                    }
+
+                    if (timing == replay_timing::original) {
+                        if (dispatched == 0) {
+                            first = header.time;
+                        } else {
+                            std::this_thread::sleep_until(start + std::chrono::nanoseconds(header.time - first));
+                        }
+                    }
+
+                    b->replay(d, payload);
+                    ++dispatched;
+                }
+
+                return dispatched;
+            }
+
+            /**
+             * The number of records the last <code>replay</code> skipped because their type wasn't bound.
+             */
+            std::size_t skipped() const {
+                return m_skipped;
+            }
+
+        private:
+            struct binding {
+                std::uint32_t schema;
+                std::uint32_t size;
+                void (*replay)(dispatcher&, const char*);
+
+                bool operator<(const binding& rhs) const {
+                    return schema < rhs.schema;
+                }
+            };
+
+            detail::mapped_file m_file;
+            std::vector<binding> m_bindings;
+            std::size_t m_skipped;
+
+            const binding* find(std::uint32_t schema) const {
+                binding key = { schema, 0, nullptr };
+
+                auto found = std::lower_bound(m_bindings.begin(), m_bindings.end(), key);
+                if (found == m_bindings.end() || found->schema != schema) {
+                    return nullptr;
+                }
+
+                return &*found;
+            }
+
+            template<class T>
+            static void replay_one(dispatcher& d, const char* payload) {
+                typedef signal_record<T> record;
+
+                // Records are aligned within the page aligned mapping, and the payload is trivially copyable.
+                d.dispatch(record::load(*reinterpret_cast<const typename record::payload*>(payload)));
+            }
+    };
+
+};
+
+/**
+ * Records <code>signal_type</code> as its <code>member</code>, which must be trivially copyable, under the
+ * schema id <code>schema_id</code>. Replaying constructs the signal from the member. Use at global scope:
+ *
+ *     DISPATCH_SIGNAL_RECORD(entity_moved_signal, 1, position)
+ */
+#define DISPATCH_SIGNAL_RECORD(signal_type, schema_id, member)                      \
+    namespace dispatch {                                                            \
+        template<> struct signal_record<signal_type> {                              \
+            typedef std::decay<decltype(std::declval<signal_type>().member)>::type payload; \
+            static const std::uint32_t schema = schema_id;                          \
+            static const payload& save(const signal_type& value) {                  \
+                return value.member;                                                \
+            }                                                                       \
+            static signal_type load(const payload& value) {                         \
+                return signal_type(value);                                          \
+            }                                                                       \
+        };                                                                          \
+    }
+
+#endif
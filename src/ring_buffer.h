@@ -0,0 +1,475 @@
+////////////////////////////////////////////////////////////////////////////////
+//
+// The MIT License (MIT)
+// 
+// Copyright (c) 2015 Matt Bolt
+// 
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+// 
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+// 
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+////////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <limits>
+#include <memory>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+
+namespace dispatch {
+
+    /**
+     * The assumed cache line size used to keep producer and consumer indices apart.
+     */
+    constexpr std::size_t cache_line_size = 64;
+
+    /**
+     * Rounds <code>n</code> up to the next power of two (minimum 2).
+     */
+    inline std::size_t ring_capacity_for(std::size_t n) {
+        std::size_t capacity = 2;
+        while (capacity < n) {
+            capacity <<= 1;
+        }
+
+        return capacity;
+    }
+
+    /**
+     * What a producer does when a bounded queue is full.
+     */
+    enum class overflow_policy {
+        /**
+         * Wait for a consumer to make room.
+         */
+        block,
+
+        /**
+         * Discard the value being pushed.
+         */
+        drop_newest,
+
+        /**
+         * Discard the oldest queued value to make room.
+         */
+        drop_oldest
+    };
+
+    /**
+     * A bounded, lock-free multi-producer multi-consumer ring (Dmitry Vyukov's sequenced cell design). Each
+     * cell carries a sequence number that tells producers and consumers whose turn it is, so neither side 
+     * ever waits on a lock. Producer and consumer indices sit on separate cache lines.
+     *
+     * Used with a single consumer, it behaves as an MPSC queue.
+     */
+    template<class T>
+    class mpmc_ring {
+        public:
+            //----------------------------------
+            //  constructor
+            //----------------------------------
+
+            explicit mpmc_ring(std::size_t capacity) 
+                : m_mask(ring_capacity_for(capacity) - 1),
+                  m_cells(new cell[m_mask + 1]),
+                  m_tail(0),
+                  m_head(0)
+            { 
+                for (std::size_t i = 0; i <= m_mask; ++i) {
+                    m_cells[i].sequence.store(i, std::memory_order_relaxed);
+                }
+            }
+
+            mpmc_ring(const mpmc_ring&) = delete;
+            mpmc_ring& operator=(const mpmc_ring&) = delete;
+
+            //----------------------------------
+            //  methods
+            //----------------------------------
+
+            /**
+             * Moves <code>value</code> in if there is room. <code>value</code> is left untouched on failure.
+             */
+            bool try_push(T& value) {
+                std::size_t position = m_tail.load(std::memory_order_relaxed);
+                for (;;) {
+                    cell& c = m_cells[position & m_mask];
+                    std::size_t sequence = c.sequence.load(std::memory_order_acquire);
+                    std::ptrdiff_t diff = static_cast<std::ptrdiff_t>(sequence) - static_cast<std::ptrdiff_t>(position);
+
+                    if (diff == 0) {
+                        if (m_tail.compare_exchange_weak(position, position + 1, std::memory_order_relaxed)) {
+                            c.value = std::move(value);
+                            c.sequence.store(position + 1, std::memory_order_release);
+                            return true;
+                        }
+                    } else if (diff < 0) {
+                        return false;
+                    } else {
+                        position = m_tail.load(std::memory_order_relaxed);
+                    }
+                }
+            }
+
+            bool try_pop(T& value) {
+                std::size_t position = m_head.load(std::memory_order_relaxed);
+                for (;;) {
+                    cell& c = m_cells[position & m_mask];
+                    std::size_t sequence = c.sequence.load(std::memory_order_acquire);
+                    std::ptrdiff_t diff = static_cast<std::ptrdiff_t>(sequence) - static_cast<std::ptrdiff_t>(position + 1);
+
+                    if (diff == 0) {
+                        if (m_head.compare_exchange_weak(position, position + 1, std::memory_order_relaxed)) {
+                            value = std::move(c.value);
+                            c.value = T();
+                            c.sequence.store(position + m_mask + 1, std::memory_order_release);
+                            return true;
+                        }
+                    } else if (diff < 0) {
+                        return false;
+                    } else {
+                        position = m_head.load(std::memory_order_relaxed);
+                    }
+                }
+            }
+
+            /**
+             * An approximate count of queued items.
+             */
+            std::size_t size() const {
+                std::size_t tail = m_tail.load(std::memory_order_acquire);
+                std::size_t head = m_head.load(std::memory_order_acquire);
+                return tail > head ? tail - head : 0;
+            }
+
+            bool empty() const {
+                return size() == 0;
+            }
+
+            std::size_t capacity() const {
+                return m_mask + 1;
+            }
+
+        private:
+            struct cell {
+                std::atomic<std::size_t> sequence;
+                T value;
+            };
+
+            const std::size_t m_mask;
+            std::unique_ptr<cell[]> m_cells;
+
+            char m_pad0[cache_line_size];
+            std::atomic<std::size_t> m_tail;
+            char m_pad1[cache_line_size - sizeof(std::atomic<std::size_t>)];
+            std::atomic<std::size_t> m_head;
+            char m_pad2[cache_line_size - sizeof(std::atomic<std::size_t>)];
+    };
+
+    namespace detail {
+
+        /**
+         * Uninitialized, contiguous value storage for the single consumer rings. Values are constructed by
+         * the producer and destroyed once the consumer has handed them on, so <code>T</code> needn't be 
+         * default constructible, and the consumer can read a run of them in place.
+         */
+        template<class T>
+        class ring_storage {
+            public:
+                explicit ring_storage(std::size_t capacity) 
+                    : m_mask(ring_capacity_for(capacity) - 1),
+                      m_values(new block[m_mask + 1])
+                { }
+
+                std::size_t capacity() const {
+                    return m_mask + 1;
+                }
+
+            protected:
+                typedef typename std::aligned_storage<sizeof(T), alignof(T)>::type block;
+
+                const std::size_t m_mask;
+                std::unique_ptr<block[]> m_values;
+
+                T* at(std::size_t position) {
+                    return reinterpret_cast<T*>(&m_values[position & m_mask]);
+                }
+
+                /**
+                 * Hands the <code>count</code> values from <code>head</code> on to <code>fn</code> as at most two 
+                 * contiguous runs (the ring may wrap), then destroys them. They're destroyed even if 
+                 * <code>fn</code> throws.
+                 */
+                template<class F>
+                void drain(std::size_t head, std::size_t count, F& fn) {
+                    struct destroy_guard {
+                        ring_storage* ring;
+                        std::size_t head;
+                        std::size_t count;
+
+                        ~destroy_guard() {
+                            for (std::size_t i = 0; i < count; ++i) {
+                                ring->at(head + i)->~T();
+                            }
+                        }
+                    } guard = { this, head, count };
+
+                    std::size_t first = std::min(count, capacity() - (head & m_mask));
+                    fn(static_cast<const T*>(at(head)), first);
+                    if (first < count) {
+                        fn(static_cast<const T*>(at(0)), count - first);
+                    }
+                }
+        };
+
+    };
+
+    /**
+     * A bounded, lock-free single-producer single-consumer ring. The producer publishes each value with one
+     * release store and keeps a cached copy of the consumer's index, so it only touches the consumer's cache
+     * line when the ring looks full. The consumer drains everything available in one pass and publishes its
+     * index once per batch.
+     */
+    template<class T>
+    class spsc_ring : public detail::ring_storage<T> {
+        public:
+            static constexpr bool multi_producer = false;
+
+            //----------------------------------
+            //  constructor
+            //----------------------------------
+
+            explicit spsc_ring(std::size_t capacity) 
+                : detail::ring_storage<T>(capacity),
+                  m_tail(0),
+                  m_head_cache(0),
+                  m_head(0)
+            { }
+
+            spsc_ring(const spsc_ring&) = delete;
+            spsc_ring& operator=(const spsc_ring&) = delete;
+
+            //----------------------------------
+            //  destructor
+            //----------------------------------
+
+            ~spsc_ring() {
+                consume([](const T*, std::size_t) { });
+            }
+
+            //----------------------------------
+            //  methods
+            //----------------------------------
+
+            /**
+             * Constructs a value from <code>args</code> at the tail if there is room.
+             */
+            template<class...Args>
+            bool try_emplace(Args&&...args) {
+                std::size_t tail = m_tail.load(std::memory_order_relaxed);
+                if (tail - m_head_cache > this->m_mask) {
+                    m_head_cache = m_head.load(std::memory_order_acquire);
+                    if (tail - m_head_cache > this->m_mask) {
+                        return false;
+                    }
+                }
+
+                new (this->at(tail)) T(std::forward<Args>(args)...);
+                m_tail.store(tail + 1, std::memory_order_release);
+                return true;
+            }
+
+            /**
+             * Passes up to <code>max</code> queued values to <code>fn(const T* values, std::size_t count)</code>,
+             * oldest first, as at most two contiguous runs. Returns how many values were consumed.
+             */
+            template<class F>
+            std::size_t consume(F fn, std::size_t max = std::numeric_limits<std::size_t>::max()) {
+                std::size_t head = m_head.load(std::memory_order_relaxed);
+                std::size_t count = std::min(m_tail.load(std::memory_order_acquire) - head, max);
+                if (count == 0) {
+                    return 0;
+                }
+
+                struct publish_guard {
+                    std::atomic<std::size_t>& head;
+                    std::size_t value;
+
+                    ~publish_guard() {
+                        head.store(value, std::memory_order_release);
+                    }
+                } guard = { m_head, head + count };
+
+                this->drain(head, count, fn);
+                return count;
+            }
+
+            /**
+             * An approximate count of queued values.
+             */
+            std::size_t size() const {
+                std::size_t head = m_head.load(std::memory_order_acquire);
+                std::size_t tail = m_tail.load(std::memory_order_acquire);
+                return tail > head ? tail - head : 0;
+            }
+
+            bool empty() const {
+                return size() == 0;
+            }
+
+        private:
+            char m_pad0[cache_line_size];
+            std::atomic<std::size_t> m_tail;
+            std::size_t m_head_cache;
+            char m_pad1[cache_line_size - sizeof(std::atomic<std::size_t>) - sizeof(std::size_t)];
+            std::atomic<std::size_t> m_head;
+            char m_pad2[cache_line_size - sizeof(std::atomic<std::size_t>)];
+    };
+
+    /**
+     * A bounded, lock-free multi-producer single-consumer ring. Producers claim cells with the same sequenced 
+     * design as <code>mpmc_ring</code>, but sequences are kept apart from the values so the single consumer can 
+     * read every ready value in place, and it needs no compare-and-swap. Values from one producer are consumed
+     * in the order it pushed them.
+     */
+    template<class T>
+    class mpsc_ring : public detail::ring_storage<T> {
+        public:
+            static constexpr bool multi_producer = true;
+
+            //----------------------------------
+            //  constructor
+            //----------------------------------
+
+            explicit mpsc_ring(std::size_t capacity) 
+                : detail::ring_storage<T>(capacity),
+                  m_sequences(new std::atomic<std::size_t>[this->m_mask + 1]),
+                  m_tail(0),
+                  m_head(0)
+            { 
+                for (std::size_t i = 0; i <= this->m_mask; ++i) {
+                    m_sequences[i].store(i, std::memory_order_relaxed);
+                }
+            }
+
+            mpsc_ring(const mpsc_ring&) = delete;
+            mpsc_ring& operator=(const mpsc_ring&) = delete;
+
+            //----------------------------------
+            //  destructor
+            //----------------------------------
+
+            ~mpsc_ring() {
+                consume([](const T*, std::size_t) { });
+            }
+
+            //----------------------------------
+            //  methods
+            //----------------------------------
+
+            /**
+             * Constructs a value from <code>args</code> in the next free cell if there is one. Safe to call
+             * from any number of threads.
+             */
+            template<class...Args>
+            bool try_emplace(Args&&...args) {
+                std::size_t position = m_tail.load(std::memory_order_relaxed);
+                for (;;) {
+                    std::size_t sequence = m_sequences[position & this->m_mask].load(std::memory_order_acquire);
+                    std::ptrdiff_t diff = static_cast<std::ptrdiff_t>(sequence) - static_cast<std::ptrdiff_t>(position);
+
+                    if (diff == 0) {
+                        if (m_tail.compare_exchange_weak(position, position + 1, std::memory_order_relaxed)) {
+                            break;
+                        }
+                    } else if (diff < 0) {
+                        return false;
+                    } else {
+                        position = m_tail.load(std::memory_order_relaxed);
+                    }
+                }
+
+                new (this->at(position)) T(std::forward<Args>(args)...);
+                m_sequences[position & this->m_mask].store(position + 1, std::memory_order_release);
+                return true;
+            }
+
+            /**
+             * Passes up to <code>max</code> ready values to <code>fn(const T* values, std::size_t count)</code>,
+             * as at most two contiguous runs. Stops at the first cell a producer has claimed but not yet filled.
+             * Must only be called from one thread at a time.
+             */
+            template<class F>
+            std::size_t consume(F fn, std::size_t max = std::numeric_limits<std::size_t>::max()) {
+                std::size_t head = m_head.load(std::memory_order_relaxed);
+
+                std::size_t count = 0;
+                while (count < max && m_sequences[(head + count) & this->m_mask].load(std::memory_order_acquire) == head + count + 1) {
+                    ++count;
+                }
+                if (count == 0) {
+                    return 0;
+                }
+
+                struct release_guard {
+                    mpsc_ring* ring;
+                    std::size_t head;
+                    std::size_t count;
+
+                    ~release_guard() {
+                        for (std::size_t i = 0; i < count; ++i) {
+                            std::size_t position = head + i;
+                            ring->m_sequences[position & ring->m_mask].store(position + ring->m_mask + 1, std::memory_order_release);
+                        }
+                        ring->m_head.store(head + count, std::memory_order_release);
+                    }
+                } guard = { this, head, count };
+
+                this->drain(head, count, fn);
+                return count;
+            }
+
+            /**
+             * An approximate count of queued values.
+             */
+            std::size_t size() const {
+                std::size_t tail = m_tail.load(std::memory_order_acquire);
+                std::size_t head = m_head.load(std::memory_order_acquire);
+                return tail > head ? tail - head : 0;
+            }
+
+            bool empty() const {
+                return size() == 0;
+            }
+
+        private:
+            std::unique_ptr<std::atomic<std::size_t>[]> m_sequences;
+
+            char m_pad0[cache_line_size];
+            std::atomic<std::size_t> m_tail;
+            char m_pad1[cache_line_size - sizeof(std::atomic<std::size_t>)];
+            std::atomic<std::size_t> m_head;
+            char m_pad2[cache_line_size - sizeof(std::atomic<std::size_t>)];
+    };
+
+};
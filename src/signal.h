@@ -26,11 +26,16 @@
 
 #pragma once
 
+#include "dispatch_context.h"
+
 namespace dispatch {
 
     /**
      * This class is used via the <code>dispatcher</code> as the dispatchable object. 
      * It allows engine components to communicate via subscription and delegation.
+     *
+     * A signal carries no dispatch state. Consuming one is done through the dispatch delivering it (see
+     * <code>dispatch_context</code>).
      */
     class signal {
         public: 
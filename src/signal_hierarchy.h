@@ -0,0 +1,227 @@
+////////////////////////////////////////////////////////////////////////////////
+//
+// The MIT License (MIT)
+// 
+// Copyright (c) 2015 Matt Bolt
+// 
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+// 
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+// 
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+////////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <mutex>
+#include <typeindex>
+#include <typeinfo>
+#include <unordered_map>
+#include <vector>
+#include "listener_list.h"
+#include "signal_id.h"
+
+
+namespace dispatch {
+
+    /**
+     * A list of base signal types. See <code>signal_bases</code>.
+     */
+    template<class...Ts> struct bases { };
+
+    /**
+     * Declares the signal types <code>T</code> derives from whose listeners should also receive <code>T</code>.
+     * C++ can't enumerate base classes, so the hierarchy is opt-in: specialize this trait, or use
+     * <code>DISPATCH_SIGNAL_BASES</code>. Only direct bases need to be listed, their own bases are followed 
+     * transitively.
+     */
+    template<class T> struct signal_bases {
+        typedef bases<> type;
+    };
+
+    /**
+     * One listener list visited when dispatching a concrete signal type. <code>visit</code> and 
+     * <code>visit_each</code> take a pointer to the concrete signal (or an array of them) and convert it to
+     * the list's type along the inheritance path the step was found through, so diamonds and multiple 
+     * inheritance resolve without a <code>dynamic_cast</code>. Both take the dispatch's frame, so a signal
+     * consumed by an earlier list isn't delivered.
+     */
+    struct route_step {
+        std::size_t id;
+        void (*visit)(listener_list&, const void*, dispatch_context&);
+        void (*visit_each)(listener_list&, const void*, std::size_t, dispatch_context&);
+    };
+
+    namespace detail {
+
+        /**
+         * Upcasts along <code>Path</code>, one base at a time.
+         */
+        template<class...Path> struct upcast_path;
+
+        template<class T> struct upcast_path<T> {
+            typedef T target;
+
+            static const T* apply(const T* value) {
+                return value;
+            }
+        };
+
+        template<class From, class Next, class...Rest> struct upcast_path<From, Next, Rest...> {
+            typedef typename upcast_path<Next, Rest...>::target target;
+
+            static const target* apply(const From* value) {
+                return upcast_path<Next, Rest...>::apply(static_cast<const Next*>(value));
+            }
+        };
+
+        template<class Bases, class...Path> struct hierarchy_bases;
+
+        /**
+         * Adds the step for the last type of <code>Path</code>, reached from the concrete type 
+         * <code>Root</code>, then walks its declared bases depth first. Types already on the route are skipped.
+         */
+        template<class Root, class...Rest> struct hierarchy_walk {
+            typedef upcast_path<Root, Rest...> path;
+            typedef typename path::target current;
+
+            static void visit(listener_list& listeners, const void* value, dispatch_context& frame) {
+                listeners.dispatch(*path::apply(static_cast<const Root*>(value)), frame);
+            }
+
+            static void visit_each(listener_list& listeners, const void* values, std::size_t count, dispatch_context& frame) {
+                listeners.template dispatch_each<current>(static_cast<const Root*>(values), count, &path::apply, frame);
+            }
+
+            static void collect(std::vector<route_step>& steps) {
+                std::size_t id = signal_id<current>::value();
+                for (const route_step& step : steps) {
+                    if (step.id == id) {
+                        return;
+                    }
+                }
+
+                route_step step = { id, &visit, &visit_each };
+                steps.push_back(step);
+
+                hierarchy_bases<typename signal_bases<current>::type, Root, Rest...>::collect(steps);
+            }
+        };
+
+        template<class...Path> struct hierarchy_bases<bases<>, Path...> {
+            static void collect(std::vector<route_step>&) { }
+        };
+
+        template<class B, class...Bs, class...Path> struct hierarchy_bases<bases<B, Bs...>, Path...> {
+            static void collect(std::vector<route_step>& steps) {
+                hierarchy_walk<Path..., B>::collect(steps);
+                hierarchy_bases<bases<Bs...>, Path...>::collect(steps);
+            }
+        };
+
+    };
+
+    /**
+     * Maps the dynamic type of a signal to its id and ancestry, for signals dispatched through a base 
+     * reference. A type is registered the first time its ancestry is built, which happens when it's 
+     * subscribed to or dispatched by its static type.
+     */
+    class signal_registry {
+        public:
+            struct entry {
+                std::size_t id;
+                const std::vector<route_step>* steps;
+            };
+
+            static signal_registry& instance() {
+                static signal_registry* registry = new signal_registry();
+                return *registry;
+            }
+
+            void add(const std::type_info& type, const entry& value) {
+                std::lock_guard<std::mutex> lock(m_lock);
+                m_types.emplace(std::type_index(type), value);
+                m_generation.fetch_add(1, std::memory_order_release);
+            }
+
+            /**
+             * Returns the entry for <code>type</code>, or one with null <code>steps</code> if it hasn't been seen.
+             */
+            entry find(const std::type_info& type) const {
+                std::lock_guard<std::mutex> lock(m_lock);
+                auto found = m_types.find(std::type_index(type));
+                if (found == m_types.end()) {
+                    entry missing = { 0, nullptr };
+                    return missing;
+                }
+
+                return found->second;
+            }
+
+            /**
+             * Changes whenever a type is added, so lookups that missed can be cached until then.
+             */
+            std::size_t generation() const {
+                return m_generation.load(std::memory_order_acquire);
+            }
+
+        private:
+            mutable std::mutex m_lock;
+            std::unordered_map<std::type_index, entry> m_types;
+            std::atomic<std::size_t> m_generation;
+
+            signal_registry() : m_generation(0) { }
+    };
+
+    /**
+     * The flattened ancestry of the concrete signal type <code>T</code>: <code>T</code> itself first, then 
+     * every declared base, depth first and without duplicates. Built once per type.
+     */
+    template<class T> 
+    class signal_hierarchy {
+        public:
+            static const std::vector<route_step>& steps() {
+                static const std::vector<route_step>* ancestry = build();
+                return *ancestry;
+            }
+
+        private:
+            static const std::vector<route_step>* build() {
+                std::vector<route_step>* steps = new std::vector<route_step>();
+                detail::hierarchy_walk<T>::collect(*steps);
+
+                signal_registry::entry value = { signal_id<T>::value(), steps };
+                signal_registry::instance().add(typeid(T), value);
+
+                return steps;
+            }
+    };
+
+};
+
+/**
+ * Declares the direct base signal types of <code>derived</code>. Use at global scope:
+ *
+ *     DISPATCH_SIGNAL_BASES(key_down_signal, key_signal, input_signal)
+ */
+#define DISPATCH_SIGNAL_BASES(derived, ...)                                         \
+    namespace dispatch {                                                            \
+        template<> struct signal_bases<derived> {                                   \
+            typedef bases<__VA_ARGS__> type;                                        \
+        };                                                                          \
+    }
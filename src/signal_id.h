@@ -0,0 +1,105 @@
+////////////////////////////////////////////////////////////////////////////////
+//
+// The MIT License (MIT)
+// 
+// Copyright (c) 2015 Matt Bolt
+// 
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+// 
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+// 
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+////////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include <cstddef>
+#include <atomic>
+#include <typeinfo>
+#include <type_traits>
+
+#ifdef DISPATCH_EXTERN_SIGNAL_IDS
+#include <mutex>
+#include <typeindex>
+#include <unordered_map>
+#endif
+
+#ifndef DISPATCH_SIGNAL_IDS_API
+#define DISPATCH_SIGNAL_IDS_API
+#endif
+
+
+namespace dispatch {
+
+    namespace detail {
+
+#ifdef DISPATCH_EXTERN_SIGNAL_IDS
+
+        /**
+         * Shared library fallback. Template statics and inline function statics are only unique per module 
+         * on platforms without vague linkage coalescing (Windows DLLs, ELF objects built with hidden visibility),
+         * so two modules could otherwise hand out different ids for the same signal type. With this macro 
+         * defined, ids are resolved by <code>std::type_index</code> through a single registry which must be 
+         * defined exactly once, in the module every other module links against, using 
+         * <code>DISPATCH_DEFINE_SIGNAL_IDS</code>. Define <code>DISPATCH_SIGNAL_IDS_API</code> as the export/import
+         * attribute for that module.
+         */
+        DISPATCH_SIGNAL_IDS_API std::size_t register_signal_id(const std::type_info& type);
+
+#else
+
+        /**
+         * Hands out the next dense signal id. Ids start at zero and are never reused.
+         */
+        inline std::size_t register_signal_id(const std::type_info&) {
+            static std::atomic<std::size_t> next(0);
+            return next.fetch_add(1, std::memory_order_relaxed);
+        }
+
+#endif
+
+    };
+
+    /**
+     * Assigns each signal type a process wide integer id on first use. The id is dense, so it can be
+     * used directly as an index into a flat table, and resolving it after the first call is a single 
+     * static load.
+     */
+    template<class T> struct signal_id {
+        static std::size_t value() {
+            static const std::size_t id = detail::register_signal_id(typeid(T));
+            return id;
+        }
+    };
+
+};
+
+#ifdef DISPATCH_EXTERN_SIGNAL_IDS
+
+/**
+ * Defines the signal id registry used by <code>DISPATCH_EXTERN_SIGNAL_IDS</code>. Use once, at global
+ * scope, in a single source file of the module that owns the registry.
+ */
+#define DISPATCH_DEFINE_SIGNAL_IDS                                                  \
+    DISPATCH_SIGNAL_IDS_API std::size_t dispatch::detail::register_signal_id(const std::type_info& type) { \
+        static std::mutex lock;                                                     \
+        static std::unordered_map<std::type_index, std::size_t> ids;                \
+        std::lock_guard<std::mutex> guard(lock);                                    \
+        auto result = ids.emplace(std::type_index(type), ids.size());               \
+        return result.first->second;                                                \
+    }
+
+#endif
@@ -0,0 +1,214 @@
+////////////////////////////////////////////////////////////////////////////////
+//
+// The MIT License (MIT)
+// 
+// Copyright (c) 2015 Matt Bolt
+// 
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+// 
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+// 
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+////////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <type_traits>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+#include "listener_list.h"
+
+
+namespace dispatch {
+
+    /**
+     * Declares how to extract the key of a signal type, for keyed listeners (see <code>dispatcher::add_keyed</code>).
+     * Specialize with a <code>type</code> and a static <code>of</code> returning the key, or use 
+     * <code>DISPATCH_SIGNAL_KEY</code>. The key must be hashable with <code>std::hash</code> (enums are 
+     * hashed by their underlying type) and comparable with <code>==</code>.
+     */
+    template<class T> struct signal_key;
+
+    namespace detail {
+
+        template<class T> std::true_type test_signal_key(typename signal_key<T>::type*);
+        template<class T> std::false_type test_signal_key(...);
+
+    };
+
+    /**
+     * Whether or not <code>T</code> has a <code>signal_key</code>.
+     */
+    template<class T> struct has_signal_key 
+        : decltype(detail::test_signal_key<T>(nullptr)) { };
+
+    template<class K, bool E = std::is_enum<K>::value> struct key_hash 
+        : std::hash<K> { };
+
+    template<class K> struct key_hash<K, true> {
+        std::size_t operator()(const K& key) const {
+            typedef typename std::underlying_type<K>::type U;
+            return std::hash<U>()(static_cast<U>(key));
+        }
+    };
+
+    /**
+     * Keyed listener lists for a single signal type, one bucket per key. Bucket numbers are stable so 
+     * subscriptions can refer to them. A bucket left empty outside a dispatch is reclaimed: its key is forgotten
+     * and its number goes to the next new key. The list itself stays, so its slot generations keep handles into
+     * the previous key from matching listeners of the next.
+     */
+    class keyed_lists_base {
+        public:
+            virtual ~keyed_lists_base() { }
+
+            /**
+             * Reclaims bucket <code>index</code> if it's empty and not being dispatched.
+             */
+            virtual void reclaim(std::uint32_t index) = 0;
+
+            listener_list& bucket(std::uint32_t index) {
+                return m_buckets[index];
+            }
+
+            std::size_t bucket_count() const {
+                return m_buckets.size();
+            }
+
+            /**
+             * The bytes held by the buckets and the key index. The index is estimated from its size.
+             */
+            virtual std::size_t memory_usage() const {
+                std::size_t bytes = m_buckets.size() * sizeof(listener_list);
+                for (const listener_list& bucket : m_buckets) {
+                    bytes += bucket.memory_usage();
+                }
+
+                return bytes;
+            }
+
+        protected:
+            /**
+             * A deque, so buckets never move once created.
+             */
+            std::deque<listener_list> m_buckets;
+    };
+
+    template<class K>
+    class keyed_lists : public keyed_lists_base {
+        public:
+            /**
+             * Returns the bucket number for <code>key</code>, creating the bucket if needed.
+             */
+            std::uint32_t bucket_for(const K& key) {
+                auto found = m_index.find(key);
+                if (found != m_index.end()) {
+                    return found->second;
+                }
+
+                std::uint32_t index;
+                if (!m_free.empty()) {
+                    index = m_free.back();
+                    m_free.pop_back();
+                } else {
+                    index = static_cast<std::uint32_t>(m_buckets.size());
+                    m_buckets.emplace_back();
+                    m_keys.push_back(nullptr);
+                }
+
+                // Node keys don't move when the index rehashes.
+                m_keys[index] = &m_index.emplace(key, index).first->first;
+
+                return index;
+            }
+
+            /**
+             * Returns the listeners for <code>key</code>, or null if nobody ever subscribed to it.
+             */
+            listener_list* find(const K& key) {
+                auto found = m_index.find(key);
+                if (found == m_index.end()) {
+                    return nullptr;
+                }
+
+                return &m_buckets[found->second];
+            }
+
+            void reclaim(std::uint32_t index) override {
+                const listener_list& bucket = m_buckets[index];
+                if (!m_keys[index] || !bucket.empty() || bucket.dispatching()) {
+                    return;
+                }
+
+                m_index.erase(m_index.find(*m_keys[index]));
+                m_keys[index] = nullptr;
+                m_free.push_back(index);
+            }
+
+            /**
+             * Reclaims the bucket for <code>key</code>, as <code>reclaim</code> does.
+             */
+            void reclaim_key(const K& key) {
+                auto found = m_index.find(key);
+                if (found != m_index.end()) {
+                    reclaim(found->second);
+                }
+            }
+
+            std::size_t memory_usage() const override {
+                typedef typename std::unordered_map<K, std::uint32_t, key_hash<K>>::value_type entry;
+
+                // Each key is a node holding the entry and a link, plus a slot in the bucket array.
+                return sizeof(*this) 
+                    + keyed_lists_base::memory_usage() 
+                    + m_index.size() * (sizeof(entry) + sizeof(void*)) 
+                    + m_index.bucket_count() * sizeof(void*)
+                    + m_keys.capacity() * sizeof(const K*)
+                    + m_free.capacity() * sizeof(std::uint32_t);
+            }
+
+        private:
+            std::unordered_map<K, std::uint32_t, key_hash<K>> m_index;
+
+            /**
+             * The key of each bucket, null once reclaimed.
+             */
+            std::vector<const K*> m_keys;
+            std::vector<std::uint32_t> m_free;
+    };
+
+};
+
+/**
+ * Keys <code>signal_type</code> on one of its members. Use at global scope:
+ *
+ *     DISPATCH_SIGNAL_KEY(entity_moved_signal, entity_id)
+ */
+#define DISPATCH_SIGNAL_KEY(signal_type, member)                                    \
+    namespace dispatch {                                                            \
+        template<> struct signal_key<signal_type> {                                 \
+            typedef std::decay<decltype(std::declval<signal_type>().member)>::type type; \
+                                                                                    \
+            static const type& of(const signal_type& value) {                       \
+                return value.member;                                                \
+            }                                                                       \
+        };                                                                          \
+    }
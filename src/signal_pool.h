@@ -0,0 +1,251 @@
+////////////////////////////////////////////////////////////////////////////////
+//
+// The MIT License (MIT)
+// 
+// Copyright (c) 2015 Matt Bolt
+// 
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+// 
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+// 
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+////////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include <cstddef>
+#include <memory>
+#include <mutex>
+#include <new>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+
+namespace dispatch {
+
+    /**
+     * A per-type object pool for signals that outlive the call that created them (queued and cross-thread 
+     * delivery). Blocks are carved out of arena chunks, cached on a thread-local free list, and moved between
+     * threads in batches (magazines) through a shared depot, so a producer thread and a consumer thread 
+     * recycle the same blocks without touching the allocator. Once the pool has grown to the working set, 
+     * <code>create</code> and <code>destroy</code> never call malloc and only take the depot lock once per batch.
+     *
+     * Arena chunks are never returned to the system.
+     */
+    template<class T>
+    class signal_pool {
+        public:
+            /**
+             * Blocks moved between a thread's cache and the depot at a time.
+             */
+            static constexpr std::size_t batch_size = 32;
+
+            /**
+             * Blocks allocated together when the pool needs to grow.
+             */
+            static constexpr std::size_t chunk_size = 64;
+
+            static signal_pool& instance() {
+                static signal_pool* pool = new signal_pool();
+                return *pool;
+            }
+
+            /**
+             * Constructs a <code>T</code> from <code>args</code> in a pooled block.
+             */
+            template<class...Args>
+            T* create(Args&&...args) {
+                block* b = acquire();
+                try {
+                    return ::new (static_cast<void*>(&b->storage)) T(std::forward<Args>(args)...);
+                } catch (...) {
+                    release(b);
+                    throw;
+                }
+            }
+
+            /**
+             * Destroys a signal made by <code>create</code> and returns its block to the calling thread's cache.
+             */
+            void destroy(T* value) {
+                value->~T();
+                release(reinterpret_cast<block*>(value));
+            }
+
+        private:
+            /**
+             * Storage comes first, so a <code>T*</code> is also the address of its block.
+             */
+            union block {
+                typename std::aligned_storage<sizeof(T), std::alignment_of<T>::value>::type storage;
+                block* next;
+            };
+
+            /**
+             * An intrusive free list of blocks.
+             */
+            struct free_list {
+                block* head;
+                std::size_t size;
+
+                free_list() : head(nullptr), size(0) { }
+
+                void push(block* b) {
+                    b->next = head;
+                    head = b;
+                    ++size;
+                }
+
+                block* pop() {
+                    block* b = head;
+                    head = b->next;
+                    --size;
+                    return b;
+                }
+
+                /**
+                 * Splits off up to <code>count</code> blocks as their own list.
+                 */
+                free_list take(std::size_t count) {
+                    free_list out;
+                    while (head && out.size < count) {
+                        out.push(pop());
+                    }
+                    return out;
+                }
+            };
+
+            /**
+             * The calling thread's cache. Anything left in it goes back to the depot when the thread exits.
+             */
+            struct local_cache {
+                free_list blocks;
+
+                ~local_cache() {
+                    while (blocks.size > 0) {
+                        signal_pool::instance().deposit(blocks.take(batch_size));
+                    }
+                }
+            };
+
+            std::mutex m_lock;
+            std::vector<free_list> m_depot;
+            std::vector<std::unique_ptr<block[]>> m_chunks;
+
+            signal_pool() { }
+
+            static free_list& local() {
+                static thread_local local_cache cache;
+                return cache.blocks;
+            }
+
+            block* acquire() {
+                free_list& cache = local();
+                if (cache.size == 0) {
+                    cache = withdraw();
+                }
+
+                return cache.pop();
+            }
+
+            void release(block* b) {
+                free_list& cache = local();
+                cache.push(b);
+
+                if (cache.size >= 2 * batch_size) {
+                    deposit(cache.take(batch_size));
+                }
+            }
+
+            void deposit(free_list blocks) {
+                std::lock_guard<std::mutex> lock(m_lock);
+                m_depot.push_back(blocks);
+            }
+
+            /**
+             * Takes a batch from the depot, or carves a new chunk out of the heap if the depot is empty.
+             */
+            free_list withdraw() {
+                std::lock_guard<std::mutex> lock(m_lock);
+                if (!m_depot.empty()) {
+                    free_list blocks = m_depot.back();
+                    m_depot.pop_back();
+                    return blocks;
+                }
+
+                std::unique_ptr<block[]> chunk(new block[chunk_size]);
+                free_list blocks;
+                for (std::size_t i = 0; i < chunk_size; ++i) {
+                    blocks.push(&chunk[i]);
+                }
+                m_chunks.push_back(std::move(chunk));
+
+                return blocks;
+            }
+    };
+
+    /**
+     * Owns a signal made by <code>signal_pool<T>::create</code> and returns it to the pool when destroyed.
+     */
+    template<class T>
+    class pooled_ptr {
+        public:
+            pooled_ptr() : m_value(nullptr) { }
+            explicit pooled_ptr(T* value) : m_value(value) { }
+            pooled_ptr(pooled_ptr&& other) noexcept : m_value(other.m_value) { other.m_value = nullptr; }
+
+            pooled_ptr(const pooled_ptr&) = delete;
+            pooled_ptr& operator=(const pooled_ptr&) = delete;
+
+            ~pooled_ptr() { 
+                reset(); 
+            }
+
+            pooled_ptr& operator=(pooled_ptr&& other) noexcept {
+                if (this != &other) {
+                    reset();
+                    m_value = other.m_value;
+                    other.m_value = nullptr;
+                }
+
+                return *this;
+            }
+
+            T& operator*() const { return *m_value; }
+            T* operator->() const { return m_value; }
+            T* get() const { return m_value; }
+
+            void reset() {
+                if (m_value) {
+                    signal_pool<T>::instance().destroy(m_value);
+                    m_value = nullptr;
+                }
+            }
+
+        private:
+            T* m_value;
+    };
+
+    /**
+     * Creates a pooled <code>T</code> in place.
+     */
+    template<class T, class...Args>
+    pooled_ptr<T> make_pooled(Args&&...args) {
+        return pooled_ptr<T>(signal_pool<T>::instance().create(std::forward<Args>(args)...));
+    }
+
+};
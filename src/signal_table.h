@@ -0,0 +1,179 @@
+////////////////////////////////////////////////////////////////////////////////
+//
+// The MIT License (MIT)
+// 
+// Copyright (c) 2015 Matt Bolt
+// 
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+// 
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+// 
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+////////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <new>
+
+
+namespace dispatch {
+
+    /**
+     * Per signal type state of a dispatcher, sorted by <code>signal_id</code>. The table is a single pointer to
+     * one block holding its size, its capacity and the (id, state) pairs. Empty tables share a static block, so
+     * an empty table allocates nothing and lookups never test for null. The block grows only as new types are 
+     * added, doubling from two entries. 
+     *
+     * The table owns its states, which are allocated separately and never move or go away until the table does,
+     * so pointers to them may be kept.
+     */
+    template<class S>
+    class signal_table {
+        public:
+            struct entry {
+                std::uint32_t id;
+                S* state;
+            };
+
+            //----------------------------------
+            //  constructor
+            //----------------------------------
+
+            signal_table() : m_block(empty_block()) { }
+
+            signal_table(const signal_table&) = delete;
+            signal_table& operator=(const signal_table&) = delete;
+
+            //----------------------------------
+            //  destructor
+            //----------------------------------
+
+            ~signal_table() {
+                for (entry* e = begin(); e != end(); ++e) {
+                    delete e->state;
+                }
+
+                if (m_block != empty_block()) {
+                    ::operator delete(m_block);
+                }
+            }
+
+            //----------------------------------
+            //  methods
+            //----------------------------------
+
+            /**
+             * Returns the state of <code>id</code>, or null if there is none.
+             */
+            S* find(std::size_t id) const {
+                const entry* first = begin();
+                const entry* last = end();
+
+                const entry* found = std::lower_bound(first, last, id, [](const entry& e, std::size_t key) { return e.id < key; });
+                if (found == last || found->id != id) {
+                    return nullptr;
+                }
+
+                return found->state;
+            }
+
+            /**
+             * Returns the state of <code>id</code>, default constructing it if there is none.
+             */
+            S& get(std::size_t id) {
+                entry* found = std::lower_bound(begin(), end(), id, [](const entry& e, std::size_t key) { return e.id < key; });
+                if (found != end() && found->id == id) {
+                    return *found->state;
+                }
+
+                std::size_t position = found - begin();
+                S* state = new S();
+
+                try {
+                    if (m_block->size == m_block->capacity) {
+                        reserve(m_block->capacity ? m_block->capacity * 2 : 2);
+                    }
+                } catch (...) {
+                    delete state;
+                    throw;
+                }
+
+                entry* at = begin() + position;
+                std::memmove(static_cast<void*>(at + 1), static_cast<const void*>(at), (m_block->size - position) * sizeof(entry));
+                at->id = static_cast<std::uint32_t>(id);
+                at->state = state;
+                ++m_block->size;
+
+                return *state;
+            }
+
+            entry* begin() const {
+                return reinterpret_cast<entry*>(m_block + 1);
+            }
+
+            entry* end() const {
+                return begin() + m_block->size;
+            }
+
+            std::size_t size() const {
+                return m_block->size;
+            }
+
+            /**
+             * The bytes of the block, not counting the states.
+             */
+            std::size_t block_bytes() const {
+                return m_block == empty_block() ? 0 : bytes_for(m_block->capacity);
+            }
+
+        private:
+            /**
+             * Followed in the same allocation by <code>capacity</code> entries.
+             */
+            struct alignas(entry) header {
+                std::uint32_t size;
+                std::uint32_t capacity;
+            };
+
+            header* m_block;
+
+            static header* empty_block() {
+                static header empty = { 0, 0 };
+                return &empty;
+            }
+
+            static std::size_t bytes_for(std::size_t capacity) {
+                return sizeof(header) + capacity * sizeof(entry);
+            }
+
+            void reserve(std::size_t capacity) {
+                header* block = static_cast<header*>(::operator new(bytes_for(capacity)));
+                block->size = m_block->size;
+                block->capacity = static_cast<std::uint32_t>(capacity);
+                std::memcpy(static_cast<void*>(block + 1), static_cast<const void*>(begin()), m_block->size * sizeof(entry));
+
+                if (m_block != empty_block()) {
+                    ::operator delete(m_block);
+                }
+                m_block = block;
+            }
+    };
+
+};
@@ -0,0 +1,241 @@
+////////////////////////////////////////////////////////////////////////////////
+//
+// The MIT License (MIT)
+// 
+// Copyright (c) 2015 Matt Bolt
+// 
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+// 
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+// 
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+////////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <tuple>
+#include <type_traits>
+#include "listener.h"
+#include "listener_list.h"
+#include "subscription.h"
+#include "helpers.h"
+
+
+namespace dispatch {
+
+    namespace detail {
+
+        /**
+         * The position of <code>T</code> in the tuple of signal types <code>Types</code>, or the tuple's size if
+         * it isn't there. This works on the tuple directly rather than through <code>template_params</code>, 
+         * which would unpack a lone class template signal (<code>static_dispatcher<foo<int>></code>) into its 
+         * own arguments.
+         */
+        template<class T, class Types, std::size_t N = 0, bool End = (N == std::tuple_size<Types>::value)> 
+        struct signal_index 
+            : std::conditional<
+                std::is_same<T, typename std::tuple_element<N, Types>::type>::value,
+                std::integral_constant<std::size_t, N>,
+                signal_index<T, Types, N + 1>>::type { };
+
+        template<class T, class Types, std::size_t N> 
+        struct signal_index<T, Types, N, true> 
+            : std::integral_constant<std::size_t, N> { };
+
+        /**
+         * The listeners of one signal type of a <code>static_dispatcher</code>.
+         */
+        template<class T> 
+        struct static_listeners {
+            listener_list listeners;
+        };
+
+    };
+
+    /**
+     * A dispatcher for a fixed set of signal types known at compile time. Each type's listeners are a member of
+     * a tuple, selected by the type's position in <code>Signals</code>, so <code>dispatch</code> has no id lookup
+     * and compiles down to a loop over one listener list. Adding a listener or dispatching a signal of any other 
+     * type doesn't compile.
+     *
+     * Listeners are added and removed with the same forms as <code>dispatcher</code>, and support priorities, 
+     * consumption and lifetime tracking. Routing to base types, keyed, sticky, coalesced and batch listeners
+     * are <code>dispatcher</code> only.
+     */
+    template<class...Signals>
+    class static_dispatcher {
+        public:
+            //----------------------------------
+            //  constructor
+            //----------------------------------
+
+            static_dispatcher() { }
+
+            static_dispatcher(const static_dispatcher&) = delete;
+            static_dispatcher& operator=(const static_dispatcher&) = delete;
+
+            //----------------------------------
+            //  methods
+            //----------------------------------
+
+            /**
+             * Adds a listener. See <code>dispatcher::add</code>.
+             */
+            template<class T>
+            subscription add(listener<T> l, int priority = 0, lifetime life = lifetime()) {
+                auto slot = listeners_of<T>().push_back(std::move(l.callable()), l.address(), priority, std::move(life));
+
+                return subscription(static_cast<std::uint32_t>(index_of<T>::value), slot.first, slot.second);
+            }
+
+            /**
+             * Adds a heap allocated listener, taking ownership of it.
+             */
+            template<class T>
+            subscription add(listener<T>* ptr, int priority = 0) {
+                std::unique_ptr<listener<T>> owned(ptr);
+                return add(std::move(*owned), priority);
+            }
+
+            template<class E>
+            void remove(const E& dispatchListener) {
+                typedef typename std::decay<function_param_at<function_type_for_t<E>, 0>>::type T;
+
+                listeners_of<T>().remove(pointer_memory<E>::address_for(dispatchListener));
+            }
+
+            /**
+             * Removes the listener behind <code>handle</code> in constant time. Returns false if the handle
+             * is stale.
+             */
+            bool remove(const subscription& handle) {
+                return handle.id < sizeof...(Signals) 
+                    && handle.bucket == 0
+                    && remove_at(handle, std::integral_constant<std::size_t, 0>());
+            }
+
+            template<class T>
+            void dispatch(const T& value) {
+                dispatch_context frame;
+                listeners_of<T>().dispatch(value, frame);
+            }
+
+            /**
+             * The number of listeners of <code>T</code>, including tracked listeners whose owner is gone but 
+             * which haven't been pruned yet.
+             */
+            template<class T>
+            std::size_t listener_count() const {
+                return std::get<index_of<T>::value>(m_listeners).listeners.size();
+            }
+
+            /**
+             * Removes every tracked listener whose owner is gone. See <code>dispatcher::prune</code>.
+             */
+            void prune() {
+                prune_from(std::integral_constant<std::size_t, 0>());
+            }
+
+            //----------------------------------
+            //  operators
+            //----------------------------------
+
+            template<class T>
+            inline subscription operator+=(const T& dispatchListener) {
+                return wrap_add(
+                    function_wrapper<T>::wrap(dispatchListener),
+                    pointer_memory<T>::address_for(dispatchListener),
+                    0);
+            }
+
+            template<class T>
+            inline subscription operator+=(const prioritized<T>& dispatchListener) {
+                typedef typename std::decay<T>::type F;
+
+                return wrap_add(
+                    function_wrapper<F>::wrap(dispatchListener.callable),
+                    pointer_memory<F>::address_for(dispatchListener.callable),
+                    dispatchListener.priority);
+            }
+
+            template<class T>
+            inline subscription operator+=(const tracked<T>& dispatchListener) {
+                return add(dispatchListener.target, 0, dispatchListener.life);
+            }
+
+            template<class T>
+            inline static_dispatcher& operator-=(const T& dispatchListener) {
+                remove<T>(dispatchListener);
+
+                return *this;
+            }
+
+            inline static_dispatcher& operator-=(const subscription& handle) {
+                remove(handle);
+
+                return *this;
+            }
+
+        private:
+            typedef std::tuple<Signals...> signals;
+
+            template<class T>
+            struct index_of : detail::signal_index<T, signals> {
+                static_assert(detail::signal_index<T, signals>::value < sizeof...(Signals), 
+                    "static_dispatcher: T is not one of the dispatcher's signal types.");
+            };
+
+            std::tuple<detail::static_listeners<Signals>...> m_listeners;
+
+            template<class T>
+            listener_list& listeners_of() {
+                return std::get<index_of<T>::value>(m_listeners).listeners;
+            }
+
+            template<class T>
+            subscription wrap_add(const T& dispatchListener, std::uintptr_t addr, int priority) {
+                typedef typename std::decay<function_param_at<T, 0>>::type E;
+                return add(listener<E>(dispatchListener, addr), priority);
+            }
+
+            /**
+             * Subscriptions carry a runtime index, so removing by handle walks the tuple to find its list.
+             */
+            template<std::size_t N>
+            bool remove_at(const subscription& handle, std::integral_constant<std::size_t, N>) {
+                if (handle.id == N) {
+                    return std::get<N>(m_listeners).listeners.remove(handle.slot, handle.generation);
+                }
+
+                return remove_at(handle, std::integral_constant<std::size_t, N + 1>());
+            }
+
+            bool remove_at(const subscription&, std::integral_constant<std::size_t, sizeof...(Signals)>) {
+                return false;
+            }
+
+            template<std::size_t N>
+            void prune_from(std::integral_constant<std::size_t, N>) {
+                std::get<N>(m_listeners).listeners.prune();
+                prune_from(std::integral_constant<std::size_t, N + 1>());
+            }
+
+            void prune_from(std::integral_constant<std::size_t, sizeof...(Signals)>) { }
+    };
+
+};
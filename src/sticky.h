@@ -0,0 +1,142 @@
+////////////////////////////////////////////////////////////////////////////////
+//
+// The MIT License (MIT)
+// 
+// Copyright (c) 2015 Matt Bolt
+// 
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+// 
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+// 
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+////////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include <new>
+#include <type_traits>
+
+
+namespace dispatch {
+
+    /**
+     * Tag for <code>dispatcher::set_sticky</code>: skip dispatches equal to the latest value.
+     */
+    struct coalesce_unchanged_t { };
+
+    constexpr coalesce_unchanged_t coalesce_unchanged = coalesce_unchanged_t();
+
+    /**
+     * The latest dispatched value of a sticky signal type. See <code>sticky_value</code>.
+     */
+    class sticky_value_base {
+        public:
+            virtual ~sticky_value_base() { }
+
+            /**
+             * Keeps a copy of <code>value</code>, which points to the concrete signal. Returns false if the 
+             * dispatch should be skipped because it's equal to the value already held.
+             */
+            virtual bool store(const void* value) = 0;
+
+            /**
+             * The bytes allocated for this object.
+             */
+            virtual std::size_t memory_usage() const = 0;
+    };
+
+    /**
+     * Holds the latest <code>T</code> in place. The first dispatch copy constructs it and later ones copy assign
+     * over it, so keeping the latest value never allocates unless <code>T</code>'s own assignment does.
+     */
+    template<class T>
+    class sticky_value : public sticky_value_base {
+        public:
+            //----------------------------------
+            //  constructor
+            //----------------------------------
+
+            sticky_value() 
+                : m_equal(nullptr), 
+                  m_engaged(false) 
+            { }
+
+            explicit sticky_value(coalesce_unchanged_t) 
+                : m_equal(&equal), 
+                  m_engaged(false) 
+            { }
+
+            sticky_value(const sticky_value&) = delete;
+            sticky_value& operator=(const sticky_value&) = delete;
+
+            //----------------------------------
+            //  destructor
+            //----------------------------------
+
+            ~sticky_value() {
+                if (m_engaged) {
+                    stored()->~T();
+                }
+            }
+
+            //----------------------------------
+            //  methods
+            //----------------------------------
+
+            std::size_t memory_usage() const override {
+                return sizeof(*this);
+            }
+
+            bool store(const void* value) override {
+                const T& next = *static_cast<const T*>(value);
+
+                if (!m_engaged) {
+                    ::new (static_cast<void*>(&m_storage)) T(next);
+                    m_engaged = true;
+                    return true;
+                }
+
+                T& latest = *stored();
+                if (m_equal && m_equal(latest, next)) {
+                    return false;
+                }
+
+                latest = next;
+                return true;
+            }
+
+            /**
+             * The latest value, or null if nothing has been dispatched yet.
+             */
+            const T* get() const {
+                return m_engaged ? reinterpret_cast<const T*>(&m_storage) : nullptr;
+            }
+
+        private:
+            typename std::aligned_storage<sizeof(T), std::alignment_of<T>::value>::type m_storage;
+            bool (*m_equal)(const T&, const T&);
+            bool m_engaged;
+
+            T* stored() {
+                return m_engaged ? reinterpret_cast<T*>(&m_storage) : nullptr;
+            }
+
+            static bool equal(const T& lhs, const T& rhs) {
+                return lhs == rhs;
+            }
+    };
+
+};
@@ -0,0 +1,77 @@
+////////////////////////////////////////////////////////////////////////////////
+//
+// The MIT License (MIT)
+// 
+// Copyright (c) 2015 Matt Bolt
+// 
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+// 
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+// 
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+////////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include <cstdint>
+
+
+namespace dispatch {
+
+    /**
+     * A lightweight handle to a single listener, returned by <code>dispatcher::add</code> and <code>+=</code>.
+     * It names a slot in the listener list for its signal type along with the slot's generation, so removing
+     * through a handle is O(1). Two subscriptions of the same callable get distinct handles. A stale handle
+     * (already removed, or whose slot has been reused) is ignored.
+     */
+    struct subscription {
+        /**
+         * The <code>signal_id</code> of the listener's signal type.
+         */
+        std::uint32_t id;
+        std::uint32_t slot;
+        std::uint32_t generation;
+
+        /**
+         * For keyed listeners, the key's bucket plus one. Zero for everything else.
+         */
+        std::uint32_t bucket;
+
+        subscription() 
+            : id(0), slot(0), generation(0), bucket(0) 
+        { }
+
+        subscription(std::uint32_t _id, std::uint32_t _slot, std::uint32_t _generation, std::uint32_t _bucket = 0)
+            : id(_id), slot(_slot), generation(_generation), bucket(_bucket)
+        { }
+
+        /**
+         * Whether or not this handle was ever issued. It does not mean the listener is still attached.
+         */
+        explicit operator bool() const {
+            return generation != 0;
+        }
+
+        inline bool operator==(const subscription& rhs) const {
+            return id == rhs.id && slot == rhs.slot && generation == rhs.generation && bucket == rhs.bucket;
+        }
+
+        inline bool operator!=(const subscription& rhs) const {
+            return !(*this == rhs);
+        }
+    };
+
+};
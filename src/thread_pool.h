@@ -0,0 +1,306 @@
+////////////////////////////////////////////////////////////////////////////////
+//
+// The MIT License (MIT)
+// 
+// Copyright (c) 2015 Matt Bolt
+// 
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+// 
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+// 
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+////////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <exception>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <thread>
+#include <utility>
+#include <vector>
+
+
+namespace dispatch {
+
+    /**
+     * Thrown by <code>thread_pool::parallel_for</code> when more than one task failed. A single failure is 
+     * rethrown as-is.
+     */
+    struct parallel_error : public std::runtime_error {
+        std::vector<std::exception_ptr> errors;
+
+        explicit parallel_error(std::vector<std::exception_ptr> _errors)
+            : std::runtime_error("dispatch::parallel_error: multiple listeners threw."),
+              errors(std::move(_errors))
+        { }
+    };
+
+    /**
+     * A small work-stealing thread pool for fork/join fan-out. Every worker owns a deque: it takes work from the 
+     * back of its own and steals from the front of the others when it runs dry. The thread that forks work 
+     * joins in on it rather than just waiting, so <code>parallel_for</code> may be nested inside tasks.
+     */
+    class thread_pool {
+        public:
+            //----------------------------------
+            //  constructor
+            //----------------------------------
+
+            explicit thread_pool(std::size_t threads = default_size())
+                : m_queues(std::max<std::size_t>(threads, 1)),
+                  m_pending(0),
+                  m_next(0),
+                  m_stopping(false)
+            {
+                for (std::size_t i = 0; i < m_queues.size(); ++i) {
+                    m_queues[i].reset(new queue());
+                }
+
+                for (std::size_t i = 0; i < m_queues.size(); ++i) {
+                    m_threads.emplace_back(&thread_pool::run, this, i);
+                }
+            }
+
+            thread_pool(const thread_pool&) = delete;
+            thread_pool& operator=(const thread_pool&) = delete;
+
+            //----------------------------------
+            //  destructor
+            //----------------------------------
+
+            ~thread_pool() {
+                {
+                    std::lock_guard<std::mutex> lock(m_sleep_lock);
+                    m_stopping = true;
+                }
+                m_wake.notify_all();
+
+                for (std::thread& t : m_threads) {
+                    t.join();
+                }
+            }
+
+            //----------------------------------
+            //  methods
+            //----------------------------------
+
+            std::size_t size() const {
+                return m_threads.size();
+            }
+
+            /**
+             * Calls <code>fn(begin, end)</code> over <code>[0, count)</code> in chunks of at most <code>grain</code>,
+             * spread across the pool and the calling thread, and returns once every chunk has finished. Exceptions
+             * thrown by chunks are collected and rethrown here. A chunk may report several failures at once by 
+             * throwing a <code>parallel_error</code>.
+             */
+            template<class F>
+            void parallel_for(std::size_t count, std::size_t grain, const F& fn) {
+                if (count == 0) {
+                    return;
+                }
+
+                grain = std::max<std::size_t>(grain, 1);
+
+                std::size_t chunks = (count + grain - 1) / grain;
+                job<F> work(fn, chunks);
+                submit(&job<F>::execute, &work, count, grain, chunks);
+
+                // Help out until no work is left to take, then wait for anything still running elsewhere. The
+                // final check happens under the job's lock, so no chunk can still be touching it once we return.
+                task next;
+                for (;;) {
+                    if (take(local_index(), next)) {
+                        next.run(next.context, next.begin, next.end);
+                        continue;
+                    }
+
+                    std::unique_lock<std::mutex> lock(work.lock);
+                    work.done.wait(lock, [&work]() { return work.remaining == 0; });
+                    break;
+                }
+
+                work.rethrow();
+            }
+
+            /**
+             * The pool used by dispatchers that don't specify one.
+             */
+            static thread_pool& shared() {
+                static thread_pool pool;
+                return pool;
+            }
+
+            static std::size_t default_size() {
+                unsigned hardware = std::thread::hardware_concurrency();
+                return hardware > 1 ? hardware - 1 : 1;
+            }
+
+        private:
+            struct task {
+                void (*run)(void*, std::size_t, std::size_t);
+                void* context;
+                std::size_t begin;
+                std::size_t end;
+            };
+
+            struct queue {
+                std::mutex lock;
+                std::deque<task> tasks;
+            };
+
+            /**
+             * Shared state for one <code>parallel_for</code>. It lives on the forking thread's stack, which
+             * doesn't return until <code>remaining</code> hits zero.
+             */
+            template<class F> struct job {
+                const F& fn;
+                std::size_t remaining;
+                std::mutex lock;
+                std::condition_variable done;
+                std::vector<std::exception_ptr> errors;
+
+                job(const F& _fn, std::size_t chunks) : fn(_fn), remaining(chunks) { }
+
+                static void execute(void* context, std::size_t begin, std::size_t end) {
+                    job* self = static_cast<job*>(context);
+
+                    std::vector<std::exception_ptr> failed;
+                    try {
+                        self->fn(begin, end);
+                    } catch (parallel_error& e) {
+                        failed = std::move(e.errors);
+                    } catch (...) {
+                        failed.push_back(std::current_exception());
+                    }
+
+                    std::lock_guard<std::mutex> lock(self->lock);
+                    self->errors.insert(self->errors.end(), failed.begin(), failed.end());
+
+                    if (--self->remaining == 0) {
+                        self->done.notify_all();
+                    }
+                }
+
+                void rethrow() {
+                    if (errors.size() == 1) {
+                        std::rethrow_exception(errors.front());
+                    }
+
+                    if (!errors.empty()) {
+                        throw parallel_error(std::move(errors));
+                    }
+                }
+            };
+
+            std::vector<std::unique_ptr<queue>> m_queues;
+            std::vector<std::thread> m_threads;
+            std::atomic<std::size_t> m_pending;
+            std::atomic<std::size_t> m_next;
+
+            std::mutex m_sleep_lock;
+            std::condition_variable m_wake;
+            bool m_stopping;
+
+            /**
+             * The index of the calling thread's queue, or <code>npos</code> for threads outside the pool.
+             */
+            static std::size_t& local_index() {
+                static thread_local std::size_t index = static_cast<std::size_t>(-1);
+                return index;
+            }
+
+            /**
+             * Queues one task per chunk. Pool threads push to their own queue and let the others steal, outside
+             * threads deal the chunks out round-robin.
+             */
+            void submit(void (*run)(void*, std::size_t, std::size_t), void* context, std::size_t count, std::size_t grain, std::size_t chunks) {
+                std::size_t own = local_index();
+                std::size_t start = m_next.fetch_add(1, std::memory_order_relaxed);
+
+                m_pending.fetch_add(chunks, std::memory_order_release);
+                for (std::size_t i = 0, begin = 0; i < chunks; ++i, begin += grain) {
+                    std::size_t target = own < m_queues.size() ? own : (start + i) % m_queues.size();
+                    std::lock_guard<std::mutex> lock(m_queues[target]->lock);
+                    m_queues[target]->tasks.push_back(task{ run, context, begin, std::min(begin + grain, count) });
+                }
+
+                {
+                    std::lock_guard<std::mutex> lock(m_sleep_lock);
+                }
+                m_wake.notify_all();
+            }
+
+            /**
+             * Pops from the back of our own queue, or steals from the front of another.
+             */
+            bool take(std::size_t own, task& out) {
+                if (own < m_queues.size()) {
+                    queue& q = *m_queues[own];
+                    std::lock_guard<std::mutex> lock(q.lock);
+                    if (!q.tasks.empty()) {
+                        out = q.tasks.back();
+                        q.tasks.pop_back();
+                        m_pending.fetch_sub(1, std::memory_order_relaxed);
+                        return true;
+                    }
+                }
+
+                for (std::size_t i = 0; i < m_queues.size(); ++i) {
+                    if (i == own) {
+                        continue;
+                    }
+
+                    queue& q = *m_queues[i];
+                    std::lock_guard<std::mutex> lock(q.lock);
+                    if (!q.tasks.empty()) {
+                        out = q.tasks.front();
+                        q.tasks.pop_front();
+                        m_pending.fetch_sub(1, std::memory_order_relaxed);
+                        return true;
+                    }
+                }
+
+                return false;
+            }
+
+            void run(std::size_t index) {
+                local_index() = index;
+
+                task next;
+                for (;;) {
+                    if (take(index, next)) {
+                        next.run(next.context, next.begin, next.end);
+                        continue;
+                    }
+
+                    std::unique_lock<std::mutex> lock(m_sleep_lock);
+                    m_wake.wait(lock, [this]() { return m_stopping || m_pending.load(std::memory_order_acquire) > 0; });
+                    if (m_stopping && m_pending.load(std::memory_order_acquire) == 0) {
+                        return;
+                    }
+                }
+            }
+    };
+
+};
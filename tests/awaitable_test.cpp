@@ -0,0 +1,263 @@
+////////////////////////////////////////////////////////////////////////////////
+//
+// The MIT License (MIT)
+// 
+// Copyright (c) 2015 Matt Bolt
+// 
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+// 
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+// 
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+////////////////////////////////////////////////////////////////////////////////
+
+// Coroutines waiting on signals: single waits, chained waits, streams, cancellation and sticky types. Built as C++20.
+
+#include <cstdio>
+#include <exception>
+#include <vector>
+#include "awaitable.h"
+#include "check.h"
+
+#ifdef DISPATCH_COROUTINES
+
+using namespace dispatch;
+
+namespace {
+
+    struct tick : public signal {
+        int value;
+
+        tick(int _value) : signal(), value(_value) { }
+
+        bool operator==(const tick& other) const {
+            return value == other.value;
+        }
+    };
+
+    /**
+     * Runs eagerly up to its first suspension, and keeps its frame until it's destroyed so tests can check 
+     * whether it finished.
+     */
+    class task {
+        public:
+            struct promise_type {
+                task get_return_object() {
+                    return task(std::coroutine_handle<promise_type>::from_promise(*this));
+                }
+
+                std::suspend_never initial_suspend() noexcept { return {}; }
+                std::suspend_always final_suspend() noexcept { return {}; }
+                void return_void() { }
+                void unhandled_exception() { std::terminate(); }
+            };
+
+            explicit task(std::coroutine_handle<promise_type> _handle) : m_handle(_handle) { }
+
+            task(task&& other) : m_handle(other.m_handle) {
+                other.m_handle = nullptr;
+            }
+
+            task(const task&) = delete;
+            task& operator=(const task&) = delete;
+
+            ~task() {
+                cancel();
+            }
+
+            bool done() const {
+                return m_handle.done();
+            }
+
+            /**
+             * Destroys the coroutine wherever it's suspended.
+             */
+            void cancel() {
+                if (m_handle) {
+                    m_handle.destroy();
+                    m_handle = nullptr;
+                }
+            }
+
+        private:
+            std::coroutine_handle<promise_type> m_handle;
+    };
+
+    task wait(dispatcher& d, std::vector<int>& seen, int count) {
+        for (int i = 0; i < count; ++i) {
+            const tick& t = co_await d.next<tick>();
+            seen.push_back(t.value);
+        }
+    }
+
+    task drain(signal_stream<tick>& ticks, std::vector<int>& seen, int count) {
+        for (int i = 0; i < count; ++i) {
+            const tick& t = co_await ticks.next();
+            seen.push_back(t.value);
+        }
+    }
+
+    void resumes_with_the_next_signal() {
+        dispatcher d;
+        std::vector<int> seen;
+
+        task waiting = wait(d, seen, 1);
+        CHECK(!waiting.done());
+        CHECK(d.memory_usage().subscriptions == 1);
+
+        d.dispatch(tick(3));
+        CHECK(waiting.done());
+        CHECK(seen == std::vector<int>({ 3 }));
+        CHECK(d.memory_usage().subscriptions == 0);
+
+        d.dispatch(tick(4));
+        CHECK(seen.size() == 1);
+    }
+
+    void chains_waits_one_signal_at_a_time() {
+        dispatcher d;
+        std::vector<int> seen;
+
+        // Each wait subscribes again from inside the dispatch that resumed it, so it gets the next signal, 
+        // not the same one.
+        task waiting = wait(d, seen, 3);
+        d.dispatch(tick(1));
+        CHECK(seen == std::vector<int>({ 1 }));
+
+        d.dispatch(tick(2));
+        d.dispatch(tick(3));
+        CHECK(waiting.done());
+        CHECK(seen == std::vector<int>({ 1, 2, 3 }));
+    }
+
+    void streams_count_missed_signals() {
+        dispatcher d;
+        std::vector<int> seen;
+        signal_stream<tick> ticks = d.stream<tick>();
+
+        d.dispatch(tick(1));
+        CHECK(ticks.missed() == 1);
+
+        task draining = drain(ticks, seen, 2);
+        d.dispatch(tick(2));
+        d.dispatch(tick(3));
+        CHECK(draining.done());
+        CHECK(seen == std::vector<int>({ 2, 3 }));
+
+        d.dispatch(tick(4));
+        CHECK(ticks.missed() == 2);
+        CHECK(d.memory_usage().subscriptions == 1);
+    }
+
+    void destroying_a_suspended_coroutine_cancels_its_wait() {
+        dispatcher d;
+        std::vector<int> seen;
+
+        task waiting = wait(d, seen, 1);
+        CHECK(d.memory_usage().subscriptions == 1);
+
+        waiting.cancel();
+        CHECK(d.memory_usage().subscriptions == 0);
+
+        d.dispatch(tick(1));
+        CHECK(seen.empty());
+    }
+
+    void next_waits_past_a_sticky_value() {
+        dispatcher d;
+        std::vector<int> seen;
+
+        d.set_sticky<tick>();
+        d.dispatch(tick(7));
+
+        task waiting = wait(d, seen, 2);
+        CHECK(!waiting.done());
+        CHECK(seen.empty());
+
+        d.dispatch(tick(8));
+        CHECK(seen == std::vector<int>({ 8 }));
+
+        d.dispatch(tick(9));
+        CHECK(waiting.done());
+        CHECK(seen == std::vector<int>({ 8, 9 }));
+    }
+
+    void streams_return_a_sticky_value_once() {
+        dispatcher d;
+        d.set_sticky<tick>();
+        d.dispatch(tick(7));
+
+        {
+            std::vector<int> seen;
+            signal_stream<tick> ticks = d.stream<tick>();
+
+            task draining = drain(ticks, seen, 2);
+            CHECK(seen == std::vector<int>({ 7 }));
+            CHECK(!draining.done());
+
+            d.dispatch(tick(8));
+            CHECK(draining.done());
+            CHECK(seen == std::vector<int>({ 7, 8 }));
+            CHECK(ticks.missed() == 0);
+        }
+
+        // Superseded by a dispatch before the first await.
+        {
+            std::vector<int> seen;
+            signal_stream<tick> ticks = d.stream<tick>();
+            d.dispatch(tick(9));
+
+            task draining = drain(ticks, seen, 1);
+            CHECK(seen.empty());
+            CHECK(ticks.missed() == 1);
+
+            d.dispatch(tick(10));
+            CHECK(seen == std::vector<int>({ 10 }));
+        }
+
+        // Cleared before the first await.
+        {
+            std::vector<int> seen;
+            signal_stream<tick> ticks = d.stream<tick>();
+            d.clear_sticky<tick>();
+
+            task draining = drain(ticks, seen, 1);
+            CHECK(seen.empty());
+            CHECK(!draining.done());
+        }
+    }
+
+};
+
+int main() {
+    resumes_with_the_next_signal();
+    chains_waits_one_signal_at_a_time();
+    streams_count_missed_signals();
+    destroying_a_suspended_coroutine_cancels_its_wait();
+    next_waits_past_a_sticky_value();
+    streams_return_a_sticky_value_once();
+
+    return dispatch_test::result();
+}
+
+#else
+
+int main() {
+    std::printf("coroutines aren't available, skipped\n");
+    return 0;
+}
+
+#endif
@@ -0,0 +1,228 @@
+////////////////////////////////////////////////////////////////////////////////
+//
+// The MIT License (MIT)
+// 
+// Copyright (c) 2015 Matt Bolt
+// 
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+// 
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+// 
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+////////////////////////////////////////////////////////////////////////////////
+
+// Channels forwarding signals between threads: ordering across ring wraparound, several producers, dropping and
+// teardown. Meant to be run under ThreadSanitizer as well (configure with -DDISPATCH_SANITIZE=thread).
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+#include "channel.h"
+#include "check.h"
+
+using namespace dispatch;
+
+namespace {
+
+    struct sequence_signal : public signal {
+        std::uint32_t source;
+        std::uint32_t sequence;
+
+        sequence_signal(std::uint32_t _source, std::uint32_t _sequence) 
+            : signal(), 
+              source(_source), 
+              sequence(_sequence) 
+        { }
+    };
+
+    struct owning_signal : public signal {
+        std::shared_ptr<int> payload;
+
+        explicit owning_signal(std::shared_ptr<int> _payload) : signal(), payload(std::move(_payload)) { }
+    };
+
+    const std::uint32_t per_source = 20000;
+
+    /**
+     * Receives sequences on the target, checking each source's arrive in order.
+     */
+    struct sequence_checker {
+        std::vector<std::uint32_t> next;
+        std::size_t received;
+        bool in_order;
+
+        explicit sequence_checker(std::size_t sources) : next(sources, 0), received(0), in_order(true) { }
+
+        void operator()(const sequence_signal& s) {
+            in_order &= s.sequence == next[s.source];
+            next[s.source] = s.sequence + 1;
+            ++received;
+        }
+    };
+
+    void keeps_order_across_wraparound() {
+        dispatcher source;
+        dispatcher target;
+        sequence_checker checker(1);
+        target += [&checker](const sequence_signal& s) { checker(s); };
+
+        // A small ring wraps around thousands of times, and the producer blocks whenever it's full.
+        spsc_channel<sequence_signal> channel(source, target, 8);
+        CHECK(channel.capacity() == 8);
+
+        std::thread producer([&source] {
+            for (std::uint32_t i = 0; i < per_source; ++i) {
+                source.dispatch(sequence_signal(0, i));
+            }
+        });
+
+        while (checker.received < per_source) {
+            if (channel.pump() == 0) {
+                std::this_thread::yield();
+            }
+        }
+        producer.join();
+
+        CHECK(checker.in_order);
+        CHECK(checker.received == per_source);
+        CHECK(channel.dropped() == 0);
+    }
+
+    void merges_several_producers_in_per_source_order() {
+        const std::uint32_t producers = 4;
+
+        std::vector<std::unique_ptr<dispatcher>> sources;
+        dispatcher target;
+        sequence_checker checker(producers);
+        target += [&checker](const sequence_signal& s) { checker(s); };
+
+        mpsc_channel<sequence_signal> channel(target, 64);
+        for (std::uint32_t p = 0; p < producers; ++p) {
+            sources.emplace_back(new dispatcher());
+            channel.connect(*sources.back());
+        }
+
+        std::vector<std::thread> threads;
+        for (std::uint32_t p = 0; p < producers; ++p) {
+            dispatcher& source = *sources[p];
+            threads.emplace_back([&source, p] {
+                for (std::uint32_t i = 0; i < per_source; ++i) {
+                    source.dispatch(sequence_signal(p, i));
+                }
+            });
+        }
+
+        while (checker.received < producers * per_source) {
+            if (channel.pump() == 0) {
+                std::this_thread::yield();
+            }
+        }
+        for (std::thread& t : threads) {
+            t.join();
+        }
+
+        CHECK(checker.in_order);
+        CHECK(checker.received == producers * per_source);
+        for (std::uint32_t p = 0; p < producers; ++p) {
+            CHECK(checker.next[p] == per_source);
+        }
+    }
+
+    void counts_dropped_signals() {
+        dispatcher source;
+        dispatcher target;
+        std::vector<std::uint32_t> seen;
+        target += [&seen](const sequence_signal& s) { seen.push_back(s.sequence); };
+
+        spsc_channel<sequence_signal> channel(source, target, 4, overflow_policy::drop_newest);
+        for (std::uint32_t i = 0; i < 10; ++i) {
+            source.dispatch(sequence_signal(0, i));
+        }
+        CHECK(channel.dropped() == 10 - channel.capacity());
+        CHECK(!channel.send(sequence_signal(0, 10)));
+        CHECK(channel.dropped() == 11 - channel.capacity());
+
+        CHECK(channel.pump() == channel.capacity());
+        CHECK(seen == std::vector<std::uint32_t>({ 0, 1, 2, 3 }));
+
+        CHECK(channel.send(sequence_signal(0, 11)));
+        CHECK(channel.pump() == 1);
+        CHECK(seen.back() == 11);
+    }
+
+    void rejects_unsupported_configurations() {
+        dispatcher first;
+        dispatcher second;
+        dispatcher target;
+
+        spsc_channel<sequence_signal> channel(first, target, 8);
+
+        bool threw = false;
+        try {
+            channel.connect(second);
+        } catch (const std::logic_error&) {
+            threw = true;
+        }
+        CHECK(threw);
+        CHECK(second.memory_usage().subscriptions == 0);
+
+        threw = false;
+        try {
+            mpsc_channel<sequence_signal> dropping(target, 8, overflow_policy::drop_oldest);
+        } catch (const std::invalid_argument&) {
+            threw = true;
+        }
+        CHECK(threw);
+    }
+
+    void destroying_drops_queued_signals() {
+        dispatcher source;
+        dispatcher target;
+        int delivered = 0;
+        target += [&delivered](const owning_signal&) { ++delivered; };
+
+        std::shared_ptr<int> payload = std::make_shared<int>(1);
+        {
+            mpsc_channel<owning_signal> channel(source, target, 16);
+            for (int i = 0; i < 5; ++i) {
+                source.dispatch(owning_signal(payload));
+            }
+            CHECK(channel.size() == 5);
+            CHECK(payload.use_count() == 6);
+        }
+
+        CHECK(payload.use_count() == 1);
+        CHECK(delivered == 0);
+        CHECK(source.memory_usage().subscriptions == 0);
+
+        source.dispatch(owning_signal(payload));
+        CHECK(payload.use_count() == 1);
+    }
+
+};
+
+int main() {
+    keeps_order_across_wraparound();
+    merges_several_producers_in_per_source_order();
+    counts_dropped_signals();
+    rejects_unsupported_configurations();
+    destroying_drops_queued_signals();
+
+    return dispatch_test::result();
+}
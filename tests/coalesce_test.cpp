@@ -0,0 +1,215 @@
+////////////////////////////////////////////////////////////////////////////////
+//
+// The MIT License (MIT)
+// 
+// Copyright (c) 2015 Matt Bolt
+// 
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+// 
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+// 
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+////////////////////////////////////////////////////////////////////////////////
+
+// Coalesced signal types: dispatches merged into one pending value per type, delivered by flush().
+
+#include <stdexcept>
+#include <vector>
+#include "dispatcher.h"
+#include "allocations.h"
+#include "check.h"
+
+using namespace dispatch;
+
+namespace {
+
+    struct position_signal : public signal {
+        int x;
+
+        position_signal(int _x) : signal(), x(_x) { }
+    };
+
+    struct scroll_signal : public signal {
+        int delta;
+
+        scroll_signal(int _delta) : signal(), delta(_delta) { }
+    };
+
+    void latest_value_wins() {
+        dispatcher d;
+        std::vector<int> seen;
+
+        d.set_coalescing<position_signal>();
+        d += [&seen](const position_signal& s) { seen.push_back(s.x); };
+
+        d.dispatch(position_signal(1));
+        d.dispatch(position_signal(2));
+        d.dispatch(position_signal(3));
+        CHECK(seen.empty());
+        CHECK(d.coalesced_events<position_signal>() == 3);
+
+        CHECK(d.flush() == 3);
+        CHECK(seen == std::vector<int>({ 3 }));
+        CHECK(d.coalesced_events<position_signal>() == 0);
+
+        CHECK(d.flush() == 0);
+        CHECK(seen.size() == 1);
+    }
+
+    void reducer_merges_each_event() {
+        dispatcher d;
+        std::vector<int> seen;
+
+        d.set_coalescing<scroll_signal>([](scroll_signal& pending, const scroll_signal& next) { 
+            pending.delta += next.delta; 
+        });
+        d += [&seen](const scroll_signal& s) { seen.push_back(s.delta); };
+
+        d.dispatch(scroll_signal(1));
+        d.dispatch(scroll_signal(2));
+
+        scroll_signal batch[] = { scroll_signal(3), scroll_signal(4) };
+        d.dispatch_batch(batch, 2);
+        CHECK(d.coalesced_events<scroll_signal>() == 4);
+
+        CHECK(d.flush() == 4);
+        CHECK(seen == std::vector<int>({ 10 }));
+    }
+
+    void flushes_types_in_order_of_their_first_event() {
+        dispatcher d;
+        std::vector<int> seen;
+
+        d.set_coalescing<position_signal>();
+        d.set_coalescing<scroll_signal>();
+        d += [&seen](const position_signal& s) { seen.push_back(s.x); };
+        d += [&seen](const scroll_signal& s) { seen.push_back(100 + s.delta); };
+
+        d.dispatch(scroll_signal(1));
+        d.dispatch(position_signal(2));
+        d.dispatch(scroll_signal(3));
+
+        CHECK(d.flush() == 3);
+        CHECK(seen == std::vector<int>({ 103, 2 }));
+    }
+
+    void listeners_coalesce_into_the_next_flush() {
+        dispatcher d;
+        std::vector<int> seen;
+        std::size_t nested = 1;
+
+        d.set_coalescing<position_signal>();
+        d += [&](const position_signal& s) { 
+            seen.push_back(s.x);
+            nested = d.flush();
+            if (s.x < 2) {
+                d.dispatch(position_signal(s.x + 1));
+            }
+        };
+
+        d.dispatch(position_signal(1));
+        CHECK(d.flush() == 1);
+        CHECK(nested == 0);
+        CHECK(seen == std::vector<int>({ 1 }));
+        CHECK(d.coalesced_events<position_signal>() == 1);
+
+        CHECK(d.flush() == 1);
+        CHECK(seen == std::vector<int>({ 1, 2 }));
+        CHECK(d.flush() == 0);
+    }
+
+    void throwing_listener_leaves_the_rest_pending() {
+        dispatcher d;
+        std::vector<int> seen;
+
+        d.set_coalescing<position_signal>();
+        d.set_coalescing<scroll_signal>();
+        d += [](const position_signal&) { throw std::runtime_error("listener"); };
+        d += [&seen](const scroll_signal& s) { seen.push_back(s.delta); };
+
+        d.dispatch(position_signal(1));
+        d.dispatch(scroll_signal(2));
+
+        bool threw = false;
+        try {
+            d.flush();
+        } catch (const std::runtime_error&) {
+            threw = true;
+        }
+
+        // The value being delivered is gone, the types after it are untouched.
+        CHECK(threw);
+        CHECK(seen.empty());
+        CHECK(d.coalesced_events<position_signal>() == 0);
+        CHECK(d.coalesced_events<scroll_signal>() == 1);
+
+        CHECK(d.flush() == 1);
+        CHECK(seen == std::vector<int>({ 2 }));
+    }
+
+    void clearing_delivers_what_is_pending() {
+        dispatcher d;
+        std::vector<int> seen;
+
+        d.set_coalescing<position_signal>();
+        d += [&seen](const position_signal& s) { seen.push_back(s.x); };
+
+        d.dispatch(position_signal(5));
+        d.clear_coalescing<position_signal>();
+        CHECK(seen == std::vector<int>({ 5 }));
+        CHECK(d.coalesced_events<position_signal>() == 0);
+
+        d.dispatch(position_signal(6));
+        CHECK(seen == std::vector<int>({ 5, 6 }));
+        CHECK(d.flush() == 0);
+    }
+
+    void dispatching_and_flushing_dont_allocate() {
+        dispatcher d;
+        int last = 0;
+
+        d.set_coalescing<position_signal>();
+        d += [&last](const position_signal& s) { last = s.x; };
+
+        // flush() swaps the pending list with the one being flushed, so both have grown after two rounds.
+        for (int i = 0; i < 2; ++i) {
+            d.dispatch(position_signal(i));
+            d.flush();
+        }
+
+        std::size_t allocations = dispatch_test::allocations([&] {
+            for (int i = 0; i < 100; ++i) {
+                d.dispatch(position_signal(i));
+            }
+            d.flush();
+        });
+        CHECK(allocations == 0);
+        CHECK(last == 99);
+    }
+
+};
+
+int main() {
+    latest_value_wins();
+    reducer_merges_each_event();
+    flushes_types_in_order_of_their_first_event();
+    listeners_coalesce_into_the_next_flush();
+    throwing_listener_leaves_the_rest_pending();
+    clearing_delivers_what_is_pending();
+    dispatching_and_flushing_dont_allocate();
+
+    return dispatch_test::result();
+}
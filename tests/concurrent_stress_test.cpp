@@ -0,0 +1,138 @@
+////////////////////////////////////////////////////////////////////////////////
+//
+// The MIT License (MIT)
+// 
+// Copyright (c) 2015 Matt Bolt
+// 
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+// 
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+// 
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+////////////////////////////////////////////////////////////////////////////////
+
+// Several threads adding, removing and dispatching on one concurrent_dispatcher at once. Meant to be run under
+// ThreadSanitizer as well (configure with -DDISPATCH_SANITIZE=thread).
+
+#include <atomic>
+#include <functional>
+#include <memory>
+#include <thread>
+#include <vector>
+#include "concurrent_dispatcher.h"
+#include "check.h"
+
+using namespace dispatch;
+
+namespace {
+
+    const int dispatch_threads = 3;
+    const int writer_threads = 2;
+    const int slots_per_writer = 8;
+    const int cycles_per_writer = 500;
+
+    struct tick_signal : public signal { };
+
+    /**
+     * One listener a writer adds and removes over and over. <code>removed</code> is set once <code>-=</code>
+     * has returned, so a call seen while it's set is a listener invoked after removal.
+     */
+    struct slot {
+        std::atomic<bool> removed;
+        std::atomic<int> calls;
+        std::function<void(const tick_signal&)> callable;
+
+        slot() : removed(true), calls(0) { }
+    };
+
+    std::atomic<int> g_late_calls(0);
+
+    void concurrent_add_remove_and_dispatch() {
+        concurrent_dispatcher d;
+        std::atomic<bool> stop(false);
+        std::atomic<long> dispatches(0);
+        std::atomic<long> permanent_calls(0);
+
+        auto permanent = [&permanent_calls](const tick_signal&) { permanent_calls.fetch_add(1); };
+        d += permanent;
+
+        std::vector<std::unique_ptr<slot>> slots;
+        for (int i = 0; i < writer_threads * slots_per_writer; ++i) {
+            slot* s = new slot();
+            s->callable = [s](const tick_signal&) {
+                if (s->removed.load()) {
+                    g_late_calls.fetch_add(1);
+                }
+                s->calls.fetch_add(1);
+            };
+            slots.emplace_back(s);
+        }
+
+        std::vector<std::thread> threads;
+        for (int t = 0; t < dispatch_threads; ++t) {
+            threads.emplace_back([&] {
+                while (!stop.load()) {
+                    d.dispatch(tick_signal());
+                    dispatches.fetch_add(1);
+                }
+            });
+        }
+
+        std::vector<std::thread> writers;
+        for (int t = 0; t < writer_threads; ++t) {
+            writers.emplace_back([&, t] {
+                for (int cycle = 0; cycle < cycles_per_writer; ++cycle) {
+                    slot& s = *slots[t * slots_per_writer + cycle % slots_per_writer];
+
+                    if (s.removed.load()) {
+                        s.removed.store(false);
+                        d += s.callable;
+                    } else {
+                        d -= s.callable;
+                        s.removed.store(true);
+                    }
+                }
+            });
+        }
+
+        for (std::thread& writer : writers) {
+            writer.join();
+        }
+        stop.store(true);
+        for (std::thread& thread : threads) {
+            thread.join();
+        }
+
+        CHECK(g_late_calls.load() == 0);
+        CHECK(permanent_calls.load() == dispatches.load());
+
+        // Once everything is quiet, exactly the slots left added are called.
+        for (std::unique_ptr<slot>& s : slots) {
+            s->calls.store(0);
+        }
+        d.dispatch(tick_signal());
+        for (std::unique_ptr<slot>& s : slots) {
+            CHECK(s->calls.load() == (s->removed.load() ? 0 : 1));
+        }
+    }
+
+};
+
+int main() {
+    concurrent_add_remove_and_dispatch();
+
+    return dispatch_test::result();
+}
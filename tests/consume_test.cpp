@@ -0,0 +1,192 @@
+////////////////////////////////////////////////////////////////////////////////
+//
+// The MIT License (MIT)
+// 
+// Copyright (c) 2015 Matt Bolt
+// 
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+// 
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+// 
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+////////////////////////////////////////////////////////////////////////////////
+
+// Consuming a signal: the consumed state belongs to each dispatch, not to the signal object.
+
+#include <cstddef>
+#include <vector>
+#include "dispatcher.h"
+#include "static_dispatcher.h"
+#include "allocations.h"
+#include "check.h"
+
+using namespace dispatch;
+
+struct key_signal : public signal {
+    int code;
+
+    key_signal(int _code) : signal(), code(_code) { }
+};
+
+struct input_signal : public signal { };
+
+struct click_signal : public input_signal { };
+
+DISPATCH_SIGNAL_BASES(click_signal, input_signal)
+
+namespace {
+
+    const int escape = 27;
+
+    void stops_lower_priority_listeners() {
+        dispatcher d;
+        int handled = 0;
+        int below = 0;
+        int batches = 0;
+
+        d += with_priority(100, [&handled](const key_signal& s) {
+            if (s.code == escape) {
+                ++handled;
+                consume();
+            }
+        });
+        d += [&below](const key_signal&) { ++below; };
+        d += [&batches](const key_signal*, std::size_t) { ++batches; };
+
+        const key_signal pressed(escape);
+        d.dispatch(pressed);
+        CHECK(handled == 1);
+        CHECK(below == 0);
+        CHECK(batches == 0);
+
+        // The same object again starts out unconsumed, and opening the frame doesn't allocate.
+        CHECK(dispatch_test::allocations([&] { d.dispatch(pressed); }) == 0);
+        CHECK(handled == 2);
+        CHECK(below == 0);
+
+        d.dispatch(key_signal(1));
+        CHECK(below == 1);
+        CHECK(batches == 1);
+    }
+
+    void stops_base_type_listeners() {
+        dispatcher d;
+        int bases = 0;
+
+        d += [](const click_signal&) { consume(); };
+        d += [&bases](const input_signal&) { ++bases; };
+
+        d.dispatch(click_signal());
+        CHECK(bases == 0);
+
+        click_signal clicks[2];
+        d.dispatch_batch(clicks, 2);
+        CHECK(bases == 0);
+    }
+
+    void consumes_each_signal_of_a_batch_separately() {
+        dispatcher d;
+        std::vector<int> seen;
+        std::size_t batched = 0;
+
+        d += with_priority(1, [](const key_signal& s) {
+            if (s.code % 2 != 0) {
+                consume();
+            }
+        });
+        d += [&seen](const key_signal& s) { seen.push_back(s.code); };
+        d += [&batched](const key_signal*, std::size_t count) { batched += count; };
+
+        // Past the flags a frame keeps inline.
+        std::vector<key_signal> keys;
+        for (int i = 0; i < 100; ++i) {
+            keys.push_back(key_signal(i));
+        }
+        seen.reserve(2 * keys.size());
+
+        d.dispatch_batch(keys);
+        CHECK(seen.size() == 50);
+        CHECK(seen.front() == 0 && seen.back() == 98);
+        CHECK(batched == 100);
+
+        CHECK(dispatch_test::allocations([&] { d.dispatch_batch(keys); }) == 0);
+        CHECK(seen.size() == 100);
+    }
+
+    void nested_dispatches_of_the_same_object_are_separate() {
+        dispatcher d;
+        dispatcher inner;
+        int outer_below = 0;
+        int inner_below = 0;
+
+        inner += with_priority(1, [](const key_signal&) { consume(); });
+        inner += [&inner_below](const key_signal&) { ++inner_below; };
+
+        d += with_priority(1, [&inner](const key_signal& s) { inner.dispatch(s); });
+        d += [&outer_below](const key_signal&) { ++outer_below; };
+
+        const key_signal pressed(1);
+        d.dispatch(pressed);
+        CHECK(inner_below == 0);
+        CHECK(outer_below == 1);
+    }
+
+    void replaying_a_sticky_value_doesnt_consume_the_outer_dispatch() {
+        dispatcher d;
+        int below = 0;
+
+        d.set_sticky<click_signal>();
+        d.dispatch(click_signal());
+
+        d += with_priority(1, [&d](const key_signal&) { 
+            d += [](const click_signal&) { consume(); };
+        });
+        d += [&below](const key_signal&) { ++below; };
+
+        d.dispatch(key_signal(1));
+        CHECK(below == 1);
+    }
+
+    void consume_outside_a_dispatch_does_nothing() {
+        CHECK(dispatch_context::current() == nullptr);
+        consume();
+
+        static_dispatcher<key_signal> d;
+        int below = 0;
+
+        d += with_priority(1, [](const key_signal&) { 
+            CHECK(dispatch_context::current() != nullptr);
+            consume(); 
+        });
+        d += [&below](const key_signal&) { ++below; };
+
+        d.dispatch(key_signal(1));
+        CHECK(below == 0);
+        CHECK(dispatch_context::current() == nullptr);
+    }
+
+};
+
+int main() {
+    stops_lower_priority_listeners();
+    stops_base_type_listeners();
+    consumes_each_signal_of_a_batch_separately();
+    nested_dispatches_of_the_same_object_are_separate();
+    replaying_a_sticky_value_doesnt_consume_the_outer_dispatch();
+    consume_outside_a_dispatch_does_nothing();
+
+    return dispatch_test::result();
+}
@@ -0,0 +1,139 @@
+////////////////////////////////////////////////////////////////////////////////
+//
+// The MIT License (MIT)
+// 
+// Copyright (c) 2015 Matt Bolt
+// 
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+// 
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+// 
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+////////////////////////////////////////////////////////////////////////////////
+
+// delegate and unique_delegate: inline and heap targets, copying, and move-only targets.
+
+#include <functional>
+#include <memory>
+#include <string>
+#include <utility>
+#include "delegate.h"
+#include "allocations.h"
+#include "check.h"
+
+using namespace dispatch;
+
+namespace {
+
+    struct adder {
+        int base;
+
+        int add(int value) {
+            return base + value;
+        }
+    };
+
+    void stores_small_targets_in_place() {
+        adder target = { 10 };
+        int bias = 5;
+
+        std::size_t made = dispatch_test::allocations([&] {
+            delegate<int(int)> method(&target, &adder::add);
+            delegate<int(int)> lambda([bias](int value) { return bias + value; });
+            delegate<int(int)> copy(lambda);
+
+            CHECK(method(1) == 11);
+            CHECK(lambda(1) == 6);
+            CHECK(copy(2) == 7);
+        });
+        CHECK(made == 0);
+    }
+
+    void copies_large_targets() {
+        std::string text(100, 'x');
+        std::string more(20, 'y');
+        delegate<std::size_t()> original([text, more]() { return text.size() + more.size(); });
+        delegate<std::size_t()> copy(original);
+
+        CHECK(original.storage().heap_bytes() > 0);
+        CHECK(copy() == 120);
+        CHECK(original() == 120);
+    }
+
+    /**
+     * Too large to be stored in place, and move-only.
+     */
+    struct large_target {
+        std::unique_ptr<int> value;
+        char padding[64];
+
+        int operator()(int add) const {
+            return *value + add;
+        }
+    };
+
+    void unique_delegate_holds_move_only_targets() {
+        std::unique_ptr<int> owned(new int(3));
+
+        unique_delegate<int(int)> inline_target(std::bind([](const std::unique_ptr<int>& value, int add) { return *value + add; }, std::move(owned), std::placeholders::_1));
+        CHECK(inline_target(1) == 4);
+
+        large_target large;
+        large.value.reset(new int(7));
+        unique_delegate<int(int)> heap_target(std::move(large));
+        CHECK(heap_target(1) == 8);
+
+        unique_delegate<int(int)> moved(std::move(heap_target));
+        CHECK(!heap_target);
+        CHECK(moved(2) == 9);
+
+        moved = unique_delegate<int(int)>();
+        CHECK(!moved);
+    }
+
+    void unique_delegate_destroys_its_target_once() {
+        std::shared_ptr<int> resource = std::make_shared<int>(0);
+        std::unique_ptr<int> token(new int(0));
+
+        {
+            struct owner {
+                std::shared_ptr<int> resource;
+                std::unique_ptr<int> token;
+
+                void operator()() const { ++*resource; }
+            };
+
+            unique_delegate<void()> first(owner{ resource, std::move(token) });
+            unique_delegate<void()> second;
+            second = std::move(first);
+            second();
+            CHECK(resource.use_count() == 2);
+        }
+
+        CHECK(*resource == 1);
+        CHECK(resource.use_count() == 1);
+    }
+
+};
+
+int main() {
+    stores_small_targets_in_place();
+    copies_large_targets();
+    unique_delegate_holds_move_only_targets();
+    unique_delegate_destroys_its_target_once();
+
+    return dispatch_test::result();
+}
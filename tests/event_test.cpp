@@ -0,0 +1,82 @@
+////////////////////////////////////////////////////////////////////////////////
+//
+// The MIT License (MIT)
+// 
+// Copyright (c) 2015 Matt Bolt
+// 
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+// 
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+// 
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+////////////////////////////////////////////////////////////////////////////////
+
+// Events: tag types whose payload is dispatched as plain arguments.
+
+#include <vector>
+#include "dispatcher.h"
+#include "allocations.h"
+#include "check.h"
+
+using namespace dispatch;
+
+namespace {
+
+    struct on_move : public event<int, float, float> { };
+
+    void dispatches_arguments_in_priority_order() {
+        dispatcher d;
+        std::vector<int> seen;
+        seen.reserve(4);
+
+        d.add<on_move>([&seen](int id, float, float) { seen.push_back(id); });
+        d.add<on_move>([&seen](int id, float x, float y) { seen.push_back(100 * id + static_cast<int>(x + y)); }, 1);
+
+        d.dispatch<on_move>(3, 1.0f, 2.0f);
+        CHECK(dispatch_test::allocations([&] { d.dispatch<on_move>(4, 0.0f, 0.0f); }) == 0);
+
+        int expected[] = { 303, 3, 400, 4 };
+        CHECK(seen == std::vector<int>(expected, expected + 4));
+    }
+
+    void removes_by_callable_and_by_subscription() {
+        dispatcher d;
+        int first = 0;
+        int second = 0;
+        auto moved = [&first](int, float, float) { ++first; };
+
+        d.add<on_move>(moved);
+        subscription handle = d.add<on_move>([&second](int, float, float) { ++second; });
+
+        d.remove<on_move>(moved);
+        d.dispatch<on_move>(1, 0.0f, 0.0f);
+        CHECK(first == 0);
+        CHECK(second == 1);
+
+        d -= handle;
+        d.dispatch<on_move>(1, 0.0f, 0.0f);
+        CHECK(second == 1);
+        CHECK(d.memory_usage().subscriptions == 0);
+    }
+
+};
+
+int main() {
+    dispatches_arguments_in_priority_order();
+    removes_by_callable_and_by_subscription();
+
+    return dispatch_test::result();
+}
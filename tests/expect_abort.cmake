@@ -0,0 +1,4 @@
+# Runs TEST and prints its output and result, whether or not it aborted, for the caller's PASS_REGULAR_EXPRESSION.
+execute_process(COMMAND ${TEST} OUTPUT_VARIABLE output ERROR_VARIABLE output RESULT_VARIABLE result)
+message("${output}")
+message("${TEST}: ${result}")
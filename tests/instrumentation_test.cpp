@@ -0,0 +1,173 @@
+////////////////////////////////////////////////////////////////////////////////
+//
+// The MIT License (MIT)
+// 
+// Copyright (c) 2015 Matt Bolt
+// 
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+// 
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+// 
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+////////////////////////////////////////////////////////////////////////////////
+
+// Dispatcher statistics, built with DISPATCH_INSTRUMENTATION: counts, latency percentiles, per-listener calls, 
+// type names and routed types.
+
+#include <cstdint>
+#include <string>
+#include <vector>
+#include "dispatcher.h"
+#include "check.h"
+
+using namespace dispatch;
+
+struct tick_signal : public signal { 
+    int work;
+
+    tick_signal(int _work) : signal(), work(_work) { }
+};
+
+struct input_signal : public signal { };
+
+struct click_signal : public input_signal { };
+
+DISPATCH_SIGNAL_BASES(click_signal, input_signal)
+
+namespace {
+
+    volatile int sink = 0;
+
+    const signal_stats* find(const std::vector<signal_stats>& stats, std::size_t id) {
+        for (const signal_stats& s : stats) {
+            if (s.id == id) {
+                return &s;
+            }
+        }
+
+        return nullptr;
+    }
+
+    void histogram_percentiles() {
+        latency_histogram latency;
+        CHECK(latency.percentile(0.5) == 0);
+
+        for (std::uint64_t ns = 1; ns <= 10000; ++ns) {
+            latency.record(ns);
+        }
+
+        CHECK(latency.count() == 10000);
+        CHECK(latency.max() == 10000);
+        CHECK(latency.total() == 10000 * 10001 / 2);
+
+        // Buckets are within 1/16 of their value.
+        std::uint64_t p50 = latency.percentile(0.5);
+        std::uint64_t p99 = latency.percentile(0.99);
+        CHECK(p50 >= 5000 - 5000 / 16 && p50 <= 5000 + 5000 / 16);
+        CHECK(p99 >= 9900 - 9900 / 16 && p99 <= 9900 + 9900 / 16);
+        CHECK(latency.percentile(0.999) >= p99);
+        CHECK(latency.percentile(0) <= p50);
+    }
+
+    void counts_dispatches_listeners_and_calls() {
+        dispatcher d;
+
+        subscription first = d += [](const tick_signal& s) { 
+            for (int i = 0; i < s.work; ++i) {
+                sink = sink + i;
+            }
+        };
+        subscription second = d += [](const tick_signal&) { };
+        d += [](const input_signal&) { };
+
+        for (int i = 0; i < 1000; ++i) {
+            d.dispatch(tick_signal(i % 10 == 0 ? 10000 : 10));
+        }
+
+        std::vector<signal_stats> stats = d.statistics();
+        const signal_stats* ticks = find(stats, signal_id<tick_signal>::value());
+        CHECK(ticks != nullptr);
+        if (!ticks) {
+            return;
+        }
+
+        CHECK(ticks->dispatches == 1000);
+        CHECK(ticks->listeners == 2);
+        CHECK(ticks->total_ns > 0);
+        CHECK(ticks->p50_ns <= ticks->p99_ns);
+        CHECK(ticks->p99_ns <= ticks->p999_ns);
+        CHECK(ticks->p999_ns <= ticks->max_ns + ticks->max_ns / 16);
+        CHECK(ticks->max_ns > 0);
+
+        CHECK(ticks->per_listener.size() == 2);
+        if (ticks->per_listener.size() == 2) {
+            CHECK(ticks->per_listener[0].handle == first);
+            CHECK(ticks->per_listener[1].handle == second);
+            CHECK(ticks->per_listener[0].calls == 1000);
+            CHECK(ticks->per_listener[1].calls == 1000);
+            CHECK(ticks->per_listener[0].total_ns >= ticks->per_listener[1].total_ns);
+        }
+
+        const signal_stats* inputs = find(stats, signal_id<input_signal>::value());
+        CHECK(inputs != nullptr && inputs->dispatches == 0 && inputs->listeners == 1);
+    }
+
+    void names_types_readably() {
+        dispatcher d;
+        d += [](const tick_signal&) { };
+
+        std::vector<signal_stats> stats = d.statistics();
+        const signal_stats* ticks = find(stats, signal_id<tick_signal>::value());
+        CHECK(ticks != nullptr);
+#ifdef DISPATCH_DEMANGLE
+        CHECK(ticks && std::string(ticks->name) == "tick_signal");
+#else
+        CHECK(ticks && ticks->name != nullptr);
+#endif
+    }
+
+    void counts_routed_types_under_themselves_and_their_bases() {
+        dispatcher d;
+        int calls = 0;
+        d += [&calls](const input_signal&) { ++calls; };
+
+        for (int i = 0; i < 5; ++i) {
+            d.dispatch(click_signal());
+        }
+        d.dispatch(input_signal());
+        CHECK(calls == 6);
+
+        std::vector<signal_stats> stats = d.statistics();
+        const signal_stats* clicks = find(stats, signal_id<click_signal>::value());
+        const signal_stats* inputs = find(stats, signal_id<input_signal>::value());
+
+        CHECK(clicks != nullptr && clicks->dispatches == 5 && clicks->listeners == 0);
+#ifdef DISPATCH_DEMANGLE
+        CHECK(clicks && std::string(clicks->name) == "click_signal");
+#endif
+        CHECK(inputs != nullptr && inputs->dispatches == 6);
+    }
+
+};
+
+int main() {
+    histogram_percentiles();
+    counts_dispatches_listeners_and_calls();
+    names_types_readably();
+    counts_routed_types_under_themselves_and_their_bases();
+
+    return dispatch_test::result();
+}
@@ -0,0 +1,144 @@
+////////////////////////////////////////////////////////////////////////////////
+//
+// The MIT License (MIT)
+// 
+// Copyright (c) 2015 Matt Bolt
+// 
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+// 
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+// 
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+////////////////////////////////////////////////////////////////////////////////
+
+// Keyed listeners, and the buckets behind them: a key nobody listens to anymore must not keep its bucket.
+
+#include <cstdint>
+#include <memory>
+#include <vector>
+#include "dispatcher.h"
+#include "check.h"
+
+using namespace dispatch;
+
+struct entity_signal : public signal {
+    std::uint32_t entity;
+
+    entity_signal(std::uint32_t _entity) : signal(), entity(_entity) { }
+};
+
+DISPATCH_SIGNAL_KEY(entity_signal, entity)
+
+namespace {
+
+    void delivers_by_key() {
+        dispatcher d;
+        std::vector<std::uint32_t> seen;
+
+        d += for_key(1u, [&seen](const entity_signal& s) { seen.push_back(s.entity); });
+        d += for_key(2u, [&seen](const entity_signal& s) { seen.push_back(10 + s.entity); });
+
+        d.dispatch(entity_signal(2));
+        d.dispatch(entity_signal(3));
+        d.dispatch(entity_signal(1));
+
+        std::uint32_t expected[] = { 12, 1 };
+        CHECK(seen == std::vector<std::uint32_t>(expected, expected + 2));
+    }
+
+    void distinct_key_churn_reuses_buckets() {
+        dispatcher d;
+
+        // Warm up, so the index and the one bucket have all the capacity they need.
+        for (std::uint32_t key = 0; key < 100; ++key) {
+            subscription handle = d += for_key(key, [](const entity_signal&) { });
+            d.remove(handle);
+        }
+        std::size_t settled = d.memory_usage().listeners;
+
+        for (std::uint32_t key = 100; key < 100000; ++key) {
+            subscription handle = d += for_key(key, [](const entity_signal&) { });
+            d.dispatch(entity_signal(key));
+            CHECK(d.remove(handle));
+        }
+
+        CHECK(d.memory_usage().listeners == settled);
+        CHECK(d.memory_usage().subscriptions == 0);
+    }
+
+    void stale_handle_does_not_remove_next_key() {
+        dispatcher d;
+        int calls = 0;
+
+        subscription first = d += for_key(1u, [](const entity_signal&) { });
+        CHECK(d.remove(first));
+
+        // Reuses the bucket key 1 gave up.
+        d += for_key(2u, [&calls](const entity_signal&) { ++calls; });
+        CHECK(!d.remove(first));
+
+        d.dispatch(entity_signal(2));
+        CHECK(calls == 1);
+    }
+
+    void bucket_emptied_during_dispatch_is_reclaimed() {
+        dispatcher d;
+        subscription self;
+        int calls = 0;
+
+        self = d += for_key(1u, [&](const entity_signal&) {
+            ++calls;
+            d.remove(self);
+        });
+        d.dispatch(entity_signal(1));
+
+        // Key 2 takes over the bucket rather than growing a new one; only its index entry is new.
+        std::size_t settled = d.memory_usage().listeners;
+        subscription next = d += for_key(2u, [&calls](const entity_signal&) { ++calls; });
+        CHECK(d.memory_usage().listeners - settled < sizeof(listener_list));
+
+        d.dispatch(entity_signal(1));
+        d.dispatch(entity_signal(2));
+        CHECK(calls == 2);
+        CHECK(d.remove(next));
+    }
+
+    void expired_keyed_listeners_are_reclaimed() {
+        dispatcher d;
+        std::shared_ptr<int> owner = std::make_shared<int>(0);
+        int calls = 0;
+
+        d.add_keyed<entity_signal>(5u, [&calls](const entity_signal&) { ++calls; }, 0, lifetime(owner));
+        d.dispatch(entity_signal(5));
+        CHECK(calls == 1);
+
+        owner.reset();
+        d.dispatch(entity_signal(5));
+        CHECK(calls == 1);
+        CHECK(d.memory_usage().subscriptions == 0);
+    }
+
+};
+
+int main() {
+    delivers_by_key();
+    distinct_key_churn_reuses_buckets();
+    stale_handle_does_not_remove_next_key();
+    bucket_emptied_during_dispatch_is_reclaimed();
+    expired_keyed_listeners_are_reclaimed();
+
+    return dispatch_test::result();
+}
@@ -0,0 +1,138 @@
+////////////////////////////////////////////////////////////////////////////////
+//
+// The MIT License (MIT)
+// 
+// Copyright (c) 2015 Matt Bolt
+// 
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+// 
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+// 
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+////////////////////////////////////////////////////////////////////////////////
+
+// The parameter forms a listener may declare, and what each one costs: const references see the dispatched
+// instance itself, every other form gets a copy of its own.
+
+#include <functional>
+#include <memory>
+#include "dispatcher.h"
+#include "allocations.h"
+#include "check.h"
+
+using namespace dispatch;
+
+namespace {
+
+    /**
+     * Counts its copies.
+     */
+    struct counted_signal : public signal {
+        static int copies;
+
+        int value;
+
+        counted_signal(int _value) : signal(), value(_value) { }
+        counted_signal(const counted_signal& other) : signal(other), value(other.value) { ++copies; }
+    };
+
+    int counted_signal::copies = 0;
+
+    struct member_listener {
+        int seen;
+
+        member_listener() : seen(0) { }
+
+        void on_signal(const counted_signal& s) {
+            seen += s.value;
+        }
+
+        void on_mutable_signal(counted_signal& s) {
+            seen += s.value;
+            s.value = 100;
+        }
+    };
+
+    void const_reference_listeners_copy_nothing() {
+        dispatcher d;
+        std::shared_ptr<member_listener> member = std::make_shared<member_listener>();
+        int seen = 0;
+
+        d += [&seen](const counted_signal& s) { seen += s.value; };
+        d += std::bind(&member_listener::on_signal, member.get(), std::placeholders::_1);
+        d += track(member, &member_listener::on_signal);
+
+        const counted_signal value(2);
+        d.dispatch(value);
+
+        counted_signal::copies = 0;
+        CHECK(dispatch_test::allocations([&] { d.dispatch(value); }) == 0);
+        CHECK(counted_signal::copies == 0);
+        CHECK(seen == 4);
+        CHECK(member->seen == 8);
+    }
+
+    void mutable_reference_listeners_get_a_copy() {
+        dispatcher d;
+        std::shared_ptr<member_listener> member = std::make_shared<member_listener>();
+        int seen = 0;
+
+        d += [&seen](counted_signal& s) { 
+            seen += s.value;
+            s.value = 100; 
+        };
+        d += std::bind(&member_listener::on_mutable_signal, member.get(), std::placeholders::_1);
+        d += track(member, &member_listener::on_mutable_signal);
+        d += [&seen](counted_signal& s) { seen += s.value; };
+
+        // A const object, which the listeners mustn't write to.
+        const counted_signal value(1);
+        counted_signal::copies = 0;
+        d.dispatch(value);
+
+        CHECK(counted_signal::copies == 4);
+        CHECK(seen == 2);
+        CHECK(member->seen == 2);
+        CHECK(value.value == 1);
+    }
+
+    void value_and_rvalue_listeners_get_a_copy() {
+        dispatcher d;
+        int seen = 0;
+
+        d += [&seen](counted_signal s) { seen += s.value; };
+        d += [&seen](counted_signal&& s) { 
+            counted_signal taken(std::move(s));
+            seen += taken.value;
+        };
+        d += [&seen](const counted_signal& s) { seen += s.value; };
+
+        counted_signal::copies = 0;
+        d.dispatch(counted_signal(1));
+
+        CHECK(counted_signal::copies == 3);
+        CHECK(seen == 3);
+    }
+
+};
+
+int main() {
+    const_reference_listeners_copy_nothing();
+    mutable_reference_listeners_get_a_copy();
+    value_and_rvalue_listeners_get_a_copy();
+
+    return dispatch_test::result();
+}
@@ -0,0 +1,106 @@
+////////////////////////////////////////////////////////////////////////////////
+//
+// The MIT License (MIT)
+// 
+// Copyright (c) 2015 Matt Bolt
+// 
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+// 
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+// 
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+////////////////////////////////////////////////////////////////////////////////
+
+// Parallel fan-out over listeners, some of which have expired. Meant to be run under ThreadSanitizer as well 
+// (configure with -DDISPATCH_SANITIZE=thread).
+
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <vector>
+#include "dispatcher.h"
+#include "check.h"
+
+using namespace dispatch;
+
+namespace {
+
+    // Every ninth listener is tracked. Chunks are dealt round-robin to the pool's four queues, so that spreads
+    // the expired listeners over all of its threads.
+    const int listener_count = 64;
+    const int tracked_every = 9;
+    const int tracked_count = (listener_count + tracked_every - 1) / tracked_every;
+    const int rounds = 100;
+
+    struct work_signal : public signal { };
+
+    /**
+     * Listeners take long enough that every pool thread gets some of the chunks.
+     */
+    void work() {
+        std::chrono::steady_clock::time_point until = std::chrono::steady_clock::now() + std::chrono::microseconds(20);
+        while (std::chrono::steady_clock::now() < until) { }
+    }
+
+    /**
+     * Expired listeners are only seen by the first dispatch after they expire, so each round starts over with 
+     * a fresh dispatcher.
+     */
+    void expired_listeners_are_skipped_and_pruned() {
+        thread_pool pool(4);
+
+        for (int round = 0; round < rounds; ++round) {
+            dispatcher d;
+            std::atomic<int> calls(0);
+            std::atomic<int> expired_calls(0);
+            std::vector<std::shared_ptr<int>> owners;
+
+            d.set_parallel<work_signal>(1, 1, pool);
+
+            for (int i = 0; i < listener_count; ++i) {
+                if (i % tracked_every == 0) {
+                    owners.push_back(std::make_shared<int>(i));
+                    d += track(owners.back(), [&expired_calls](const work_signal&) { expired_calls.fetch_add(1); });
+                } else {
+                    d += [&calls](const work_signal&) {
+                        work();
+                        calls.fetch_add(1);
+                    };
+                }
+            }
+
+            d.dispatch(work_signal());
+            CHECK(calls.load() == listener_count - tracked_count);
+            CHECK(expired_calls.load() == tracked_count);
+
+            // Several chunks run into expired listeners at once.
+            owners.clear();
+            d.dispatch(work_signal());
+            CHECK(d.memory_usage().subscriptions == static_cast<std::size_t>(listener_count - tracked_count));
+
+            d.dispatch(work_signal());
+            CHECK(calls.load() == 3 * (listener_count - tracked_count));
+            CHECK(expired_calls.load() == tracked_count);
+        }
+    }
+
+};
+
+int main() {
+    expired_listeners_are_skipped_and_pruned();
+
+    return dispatch_test::result();
+}
@@ -0,0 +1,59 @@
+////////////////////////////////////////////////////////////////////////////////
+//
+// The MIT License (MIT)
+// 
+// Copyright (c) 2015 Matt Bolt
+// 
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+// 
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+// 
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+////////////////////////////////////////////////////////////////////////////////
+
+// A listener of a parallel type that subscribes through the dispatcher it's running under must trip the debug
+// assert instead of racing with the other chunks. Built with asserts enabled, and passes when the assert's 
+// message is printed.
+
+#include <cstdio>
+#include "dispatcher.h"
+
+using namespace dispatch;
+
+namespace {
+
+    struct parallel_signal : public signal { };
+
+    struct other_signal : public signal { };
+};
+
+int main() {
+    thread_pool pool(4);
+    dispatcher d;
+
+    d.set_parallel<parallel_signal>(2, 1, pool);
+
+    for (int i = 0; i < 64; ++i) {
+        d += [&d](const parallel_signal&) { 
+            d += [](const other_signal&) { };
+        };
+    }
+
+    d.dispatch(parallel_signal());
+
+    std::fprintf(stderr, "subscribing from a parallel listener wasn't caught\n");
+    return 1;
+}
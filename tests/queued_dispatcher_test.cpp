@@ -0,0 +1,119 @@
+////////////////////////////////////////////////////////////////////////////////
+//
+// The MIT License (MIT)
+// 
+// Copyright (c) 2015 Matt Bolt
+// 
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+// 
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+// 
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+////////////////////////////////////////////////////////////////////////////////
+
+// Queued dispatch. Each queued signal is a move-only work item owning its pooled payload.
+
+#include <atomic>
+#include <vector>
+#include "queued_dispatcher.h"
+#include "check.h"
+
+using namespace dispatch;
+
+namespace {
+
+    /**
+     * Counts live instances, to check that every queued signal goes back to the pool.
+     */
+    struct tracked_signal : public signal {
+        static std::atomic<int> live;
+
+        int value;
+
+        tracked_signal(int _value) : signal(), value(_value) { ++live; }
+        tracked_signal(const tracked_signal& other) : signal(other), value(other.value) { ++live; }
+        ~tracked_signal() { --live; }
+    };
+
+    std::atomic<int> tracked_signal::live(0);
+
+    void pump_delivers_in_order() {
+        dispatcher target;
+        basic_queued_dispatcher<dispatcher> queue(target, 16);
+        std::vector<int> seen;
+
+        target += [&seen](const tracked_signal& s) { seen.push_back(s.value); };
+
+        for (int i = 0; i < 5; ++i) {
+            CHECK(queue.post(tracked_signal(i)));
+        }
+        CHECK(queue.emplace<tracked_signal>(5));
+        CHECK(seen.empty());
+
+        CHECK(queue.pump() == 6);
+
+        int expected[] = { 0, 1, 2, 3, 4, 5 };
+        CHECK(seen == std::vector<int>(expected, expected + 6));
+        CHECK(tracked_signal::live.load() == 0);
+    }
+
+    void dropped_signals_are_released() {
+        dispatcher target;
+        basic_queued_dispatcher<dispatcher> queue(target, 4, overflow_policy::drop_newest);
+        int calls = 0;
+
+        target += [&calls](const tracked_signal&) { ++calls; };
+
+        int accepted = 0;
+        for (int i = 0; i < 10; ++i) {
+            accepted += queue.emplace<tracked_signal>(i) ? 1 : 0;
+        }
+        CHECK(accepted == 4);
+        CHECK(queue.dropped() == 6);
+        CHECK(tracked_signal::live.load() == 4);
+
+        queue.pump();
+        CHECK(calls == 4);
+        CHECK(tracked_signal::live.load() == 0);
+    }
+
+    void workers_drain_the_queue() {
+        concurrent_dispatcher target;
+        std::atomic<int> total(0);
+        auto add = [&total](const tracked_signal& s) { total.fetch_add(s.value); };
+        target += add;
+
+        {
+            queued_dispatcher queue(target, 64);
+            queue.start(2);
+            for (int i = 1; i <= 1000; ++i) {
+                queue.emplace<tracked_signal>(i);
+            }
+        }
+
+        CHECK(total.load() == 500500);
+        CHECK(tracked_signal::live.load() == 0);
+    }
+
+};
+
+int main() {
+    pump_delivers_in_order();
+    dropped_signals_are_released();
+    workers_drain_the_queue();
+
+    return dispatch_test::result();
+}
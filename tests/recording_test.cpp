@@ -0,0 +1,263 @@
+////////////////////////////////////////////////////////////////////////////////
+//
+// The MIT License (MIT)
+// 
+// Copyright (c) 2015 Matt Bolt
+// 
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+// 
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+// 
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+////////////////////////////////////////////////////////////////////////////////
+
+// Recording signals to a log and replaying them: growth, unbound and mismatched schemas, logs cut short, and
+// original timing.
+
+#include <chrono>
+#include <cstdio>
+#include <fstream>
+#include <iterator>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+#include "recording.h"
+#include "check.h"
+
+#ifdef DISPATCH_RECORDING
+
+using namespace dispatch;
+
+struct tick_signal : public signal {
+    int frame;
+
+    tick_signal(int _frame) : signal(), frame(_frame) { }
+};
+
+struct score_signal : public signal {
+    double points;
+
+    score_signal(double _points) : signal(), points(_points) { }
+};
+
+/**
+ * Shares <code>tick_signal</code>'s schema with a different payload size.
+ */
+struct wide_tick_signal : public signal {
+    double frame;
+
+    wide_tick_signal(double _frame) : signal(), frame(_frame) { }
+};
+
+DISPATCH_SIGNAL_RECORD(tick_signal, 1, frame)
+DISPATCH_SIGNAL_RECORD(score_signal, 2, points)
+DISPATCH_SIGNAL_RECORD(wide_tick_signal, 1, frame)
+
+namespace {
+
+    const char* log_path = "recording_test.log";
+    const char* copy_path = "recording_test_copy.log";
+
+    std::string read_file(const char* path) {
+        std::ifstream in(path, std::ios::binary);
+        return std::string(std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>());
+    }
+
+    void write_file(const char* path, const std::string& bytes) {
+        std::ofstream out(path, std::ios::binary | std::ios::trunc);
+        out.write(bytes.data(), static_cast<std::streamsize>(bytes.size()));
+    }
+
+    /**
+     * Replays <code>path</code>'s ticks into a fresh dispatcher.
+     */
+    std::vector<int> replay_ticks(const char* path, std::size_t& dispatched) {
+        dispatcher d;
+        std::vector<int> frames;
+        d += [&frames](const tick_signal& s) { frames.push_back(s.frame); };
+
+        signal_replayer replayer(path);
+        replayer.bind<tick_signal>();
+        dispatched = replayer.replay(d);
+
+        return frames;
+    }
+
+    void round_trips_past_the_initial_mapping() {
+        dispatcher d;
+        {
+            signal_recorder recorder(log_path, 64);
+            recorder.record<tick_signal>(d);
+
+            for (int i = 0; i < 1000; ++i) {
+                d.dispatch(tick_signal(i));
+            }
+            CHECK(recorder.records() == 1000);
+        }
+        CHECK(d.memory_usage().subscriptions == 0);
+
+        std::size_t dispatched = 0;
+        std::vector<int> frames = replay_ticks(log_path, dispatched);
+        CHECK(dispatched == 1000);
+        CHECK(frames.size() == 1000);
+
+        bool in_order = true;
+        for (std::size_t i = 0; i < frames.size(); ++i) {
+            in_order &= frames[i] == static_cast<int>(i);
+        }
+        CHECK(in_order);
+    }
+
+    void skips_unbound_schemas() {
+        dispatcher d;
+        {
+            signal_recorder recorder(log_path);
+            recorder.record<tick_signal>(d);
+            recorder.record<score_signal>(d);
+
+            d.dispatch(tick_signal(1));
+            d.dispatch(score_signal(2.5));
+            d.dispatch(tick_signal(3));
+        }
+
+        dispatcher target;
+        std::vector<int> frames;
+        target += [&frames](const tick_signal& s) { frames.push_back(s.frame); };
+
+        signal_replayer replayer(log_path);
+        replayer.bind<tick_signal>();
+        CHECK(replayer.replay(target) == 2);
+        CHECK(replayer.skipped() == 1);
+        CHECK(frames == std::vector<int>({ 1, 3 }));
+    }
+
+    void rejects_a_payload_size_mismatch() {
+        dispatcher d;
+        {
+            signal_recorder recorder(log_path);
+            recorder.record<tick_signal>(d);
+            d.dispatch(tick_signal(1));
+        }
+
+        dispatcher target;
+        signal_replayer replayer(log_path);
+        replayer.bind<wide_tick_signal>();
+
+        bool threw = false;
+        try {
+            replayer.replay(target);
+        } catch (const std::runtime_error&) {
+            threw = true;
+        }
+        CHECK(threw);
+    }
+
+    void replays_a_truncated_log_up_to_its_last_complete_record() {
+        dispatcher d;
+        {
+            signal_recorder recorder(log_path);
+            recorder.record<tick_signal>(d);
+            for (int i = 0; i < 3; ++i) {
+                d.dispatch(tick_signal(i));
+            }
+        }
+
+        // Cut off part way through the last payload, then part way through the last header.
+        std::string bytes = read_file(log_path);
+        std::size_t record = (bytes.size() - sizeof(detail::log_header)) / 3;
+
+        write_file(copy_path, bytes.substr(0, bytes.size() - 4));
+        std::size_t dispatched = 0;
+        CHECK(replay_ticks(copy_path, dispatched) == std::vector<int>({ 0, 1 }));
+        CHECK(dispatched == 2);
+
+        write_file(copy_path, bytes.substr(0, bytes.size() - record + 4));
+        CHECK(replay_ticks(copy_path, dispatched) == std::vector<int>({ 0, 1 }));
+    }
+
+    void stops_at_the_zero_padded_tail() {
+        dispatcher d;
+        signal_recorder recorder(log_path);
+        recorder.record<tick_signal>(d);
+        d.dispatch(tick_signal(1));
+        d.dispatch(tick_signal(2));
+
+        // Still open, so the file is the whole mapping: the records, then zeros, as a crash would leave it.
+        std::string bytes = read_file(log_path);
+        CHECK(bytes.size() > recorder.bytes());
+        write_file(copy_path, bytes);
+
+        std::size_t dispatched = 0;
+        CHECK(replay_ticks(copy_path, dispatched) == std::vector<int>({ 1, 2 }));
+        CHECK(dispatched == 2);
+    }
+
+    void original_timing_keeps_order_and_gaps() {
+        const std::chrono::milliseconds gap(20);
+
+        dispatcher d;
+        {
+            signal_recorder recorder(log_path);
+            recorder.record<tick_signal>(d);
+            recorder.record<score_signal>(d);
+
+            d.dispatch(tick_signal(1));
+            std::this_thread::sleep_for(gap);
+            d.dispatch(score_signal(2));
+            std::this_thread::sleep_for(gap);
+            d.dispatch(tick_signal(3));
+        }
+
+        dispatcher target;
+        std::vector<int> order;
+        target += [&order](const tick_signal& s) { order.push_back(s.frame); };
+        target += [&order](const score_signal& s) { order.push_back(static_cast<int>(s.points)); };
+
+        signal_replayer replayer(log_path);
+        replayer.bind<tick_signal>();
+        replayer.bind<score_signal>();
+
+        std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+        CHECK(replayer.replay(target, replay_timing::original) == 3);
+        CHECK(std::chrono::steady_clock::now() - start >= 2 * gap);
+        CHECK(order == std::vector<int>({ 1, 2, 3 }));
+    }
+
+};
+
+int main() {
+    round_trips_past_the_initial_mapping();
+    skips_unbound_schemas();
+    rejects_a_payload_size_mismatch();
+    replays_a_truncated_log_up_to_its_last_complete_record();
+    stops_at_the_zero_padded_tail();
+    original_timing_keeps_order_and_gaps();
+
+    std::remove(log_path);
+    std::remove(copy_path);
+
+    return dispatch_test::result();
+}
+
+#else
+
+int main() {
+    std::printf("recording isn't available, skipped\n");
+    return 0;
+}
+
+#endif
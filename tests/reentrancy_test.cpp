@@ -0,0 +1,260 @@
+////////////////////////////////////////////////////////////////////////////////
+//
+// The MIT License (MIT)
+// 
+// Copyright (c) 2015 Matt Bolt
+// 
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+// 
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+// 
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+////////////////////////////////////////////////////////////////////////////////
+
+// Listeners that change the dispatcher they are being called from: removing themselves or others, adding new
+// listeners, and dispatching again before the outer dispatch has finished.
+
+#include <string>
+#include <vector>
+#include "dispatcher.h"
+#include "allocations.h"
+#include "check.h"
+
+using namespace dispatch;
+
+namespace {
+
+    struct count_signal : public signal {
+        int value;
+
+        count_signal(int _value) : signal(), value(_value) { }
+    };
+
+    struct other_signal : public signal { };
+
+    //----------------------------------
+    //  Removal
+    //----------------------------------
+
+    void removes_current_listener() {
+        dispatcher d;
+        subscription self;
+        std::string capture(100, 'x');
+        int calls = 0;
+
+        // A capture too large for inline storage, so the listener being run owns heap memory.
+        self = d += [&, capture](const count_signal&) {
+            ++calls;
+            d.remove(self);
+            CHECK(capture.size() == 100);
+        };
+
+        for (int i = 0; i < 10; ++i) {
+            d.add(listener<count_signal>([&calls](const count_signal&) { ++calls; }, 100 + i));
+        }
+
+        d.dispatch(count_signal(0));
+        CHECK(calls == 11);
+
+        d.dispatch(count_signal(0));
+        CHECK(calls == 21);
+        CHECK(d.memory_usage().subscriptions == 10);
+    }
+
+    void removes_following_listeners() {
+        dispatcher d;
+        std::vector<subscription> handles;
+        int calls = 0;
+
+        handles.push_back(d += [&](const count_signal&) {
+            ++calls;
+
+            for (std::size_t i = 1; i < handles.size(); ++i) {
+                d.remove(handles[i]);
+            }
+        });
+
+        for (int i = 0; i < 20; ++i) {
+            handles.push_back(d.add(listener<count_signal>([&calls](const count_signal&) { ++calls; }, 1 + i)));
+        }
+
+        d.dispatch(count_signal(0));
+        CHECK(calls == 1);
+
+        d.dispatch(count_signal(0));
+        CHECK(calls == 2);
+    }
+
+    void removal_during_dispatch_does_not_allocate() {
+        dispatcher d;
+        std::vector<subscription> handles;
+        int calls = 0;
+
+        handles.reserve(2);
+        handles.push_back(d += [&](const count_signal&) {
+            ++calls;
+
+            if (handles.size() > 1) {
+                d.remove(handles[1]);
+            }
+        });
+        handles.push_back(d += [&calls](const count_signal&) { ++calls; });
+
+        d.dispatch(count_signal(0));
+        CHECK(calls == 1);
+        CHECK(dispatch_test::allocations([&] { d.dispatch(count_signal(0)); }) == 0);
+        CHECK(calls == 2);
+    }
+
+    //----------------------------------
+    //  Addition
+    //----------------------------------
+
+    void add_during_dispatch_waits_for_next_dispatch() {
+        dispatcher d;
+        std::vector<subscription> added;
+        int outer = 0;
+        int inner = 0;
+
+        // Enough additions to force the listener arrays to grow while they are being iterated.
+        d += [&](const count_signal&) {
+            ++outer;
+
+            if (outer == 1) {
+                for (int i = 0; i < 100; ++i) {
+                    added.push_back(d.add(listener<count_signal>([&inner](const count_signal&) { ++inner; }, 1000 + i), i % 5));
+                }
+            }
+        };
+
+        d.dispatch(count_signal(0));
+        CHECK(outer == 1);
+        CHECK(inner == 0);
+
+        d.dispatch(count_signal(0));
+        CHECK(outer == 2);
+        CHECK(inner == 100);
+
+        for (std::size_t i = 0; i < added.size(); ++i) {
+            CHECK(d.remove(added[i]));
+        }
+        CHECK(d.memory_usage().subscriptions == 1);
+    }
+
+    void add_and_remove_in_same_dispatch() {
+        dispatcher d;
+        int calls = 0;
+        auto counter = [&calls](const count_signal&) { calls += 1000; };
+
+        d += [&](const count_signal&) {
+            subscription handle = d += [&calls](const count_signal&) { calls += 1; };
+            CHECK(d.remove(handle));
+            CHECK(!d.remove(handle));
+
+            d += counter;
+            d -= counter;
+        };
+
+        d.dispatch(count_signal(0));
+        d.dispatch(count_signal(0));
+        CHECK(calls == 0);
+        CHECK(d.memory_usage().subscriptions == 1);
+    }
+
+    //----------------------------------
+    //  Nested Dispatch
+    //----------------------------------
+
+    void nested_dispatch_of_same_type() {
+        dispatcher d;
+        std::vector<int> order;
+        int depth = 0;
+        int deepest = 0;
+        int others = 0;
+
+        d += [&](const count_signal& s) {
+            ++depth;
+            deepest = depth > deepest ? depth : deepest;
+            order.push_back(s.value);
+
+            if (s.value < 5) {
+                d.dispatch(count_signal(s.value + 1));
+            }
+            d.dispatch(other_signal());
+            --depth;
+        };
+        d += [&](const count_signal& s) { order.push_back(100 + s.value); };
+        d += [&others](const other_signal&) { ++others; };
+
+        d.dispatch(count_signal(0));
+        CHECK(deepest == 6);
+        CHECK(others == 6);
+
+        // Each nested dispatch reaches both listeners before the outer dispatch moves on to its second listener.
+        int expected[] = { 0, 1, 2, 3, 4, 5, 105, 104, 103, 102, 101, 100 };
+        CHECK(order == std::vector<int>(expected, expected + 12));
+    }
+
+    void nested_dispatch_with_removal() {
+        dispatcher d;
+        subscription second;
+        int calls = 0;
+
+        d += [&](const count_signal& s) {
+            if (s.value == 0) {
+                d.dispatch(count_signal(1));
+                d.remove(second);
+                d.dispatch(count_signal(2));
+            }
+        };
+        second = d += [&calls](const count_signal&) { ++calls; };
+
+        d.dispatch(count_signal(0));
+        CHECK(calls == 1);
+        CHECK(d.memory_usage().subscriptions == 1);
+    }
+
+    void nested_dispatch_does_not_allocate() {
+        dispatcher d;
+        int calls = 0;
+
+        d += [&](const count_signal& s) {
+            ++calls;
+
+            if (s.value < 3) {
+                d.dispatch(count_signal(s.value + 1));
+            }
+        };
+
+        d.dispatch(count_signal(0));
+        CHECK(dispatch_test::allocations([&] { d.dispatch(count_signal(0)); }) == 0);
+        CHECK(calls == 8);
+    }
+
+};
+
+int main() {
+    removes_current_listener();
+    removes_following_listeners();
+    removal_during_dispatch_does_not_allocate();
+    add_during_dispatch_waits_for_next_dispatch();
+    add_and_remove_in_same_dispatch();
+    nested_dispatch_of_same_type();
+    nested_dispatch_with_removal();
+    nested_dispatch_does_not_allocate();
+
+    return dispatch_test::result();
+}
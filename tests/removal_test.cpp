@@ -0,0 +1,203 @@
+////////////////////////////////////////////////////////////////////////////////
+//
+// The MIT License (MIT)
+// 
+// Copyright (c) 2015 Matt Bolt
+// 
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+// 
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+// 
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+////////////////////////////////////////////////////////////////////////////////
+
+// What a removed listener leaves behind: its captures have to go when it's removed, not whenever the listener 
+// list next compacts.
+
+#include <functional>
+#include <memory>
+#include "dispatcher.h"
+#include "check.h"
+
+using namespace dispatch;
+
+struct keyed_signal : public signal {
+    int key;
+
+    keyed_signal(int _key) : signal(), key(_key) { }
+};
+
+DISPATCH_SIGNAL_KEY(keyed_signal, key)
+
+namespace {
+
+    struct ping_signal : public signal { };
+
+    /**
+     * Enough listeners that one tombstone doesn't make the list compact.
+     */
+    void add_bystanders(dispatcher& d) {
+        for (int i = 0; i < 10; ++i) {
+            d.add(listener<ping_signal>([](const ping_signal&) { }, 100 + i));
+        }
+    }
+
+    //----------------------------------
+    //  Removal by Address
+    //----------------------------------
+
+    void remove_by_address_releases_captures() {
+        dispatcher d;
+        std::shared_ptr<int> resource = std::make_shared<int>(0);
+        auto callable = [resource](const ping_signal&) { ++*resource; };
+
+        add_bystanders(d);
+        d += callable;
+        CHECK(resource.use_count() == 3);
+
+        d -= callable;
+        CHECK(resource.use_count() == 2);
+    }
+
+    void remove_by_address_during_dispatch_releases_captures_after_dispatch() {
+        dispatcher d;
+        std::shared_ptr<int> resource = std::make_shared<int>(0);
+        auto callable = [resource](const ping_signal&) { ++*resource; };
+        long during = 0;
+
+        add_bystanders(d);
+        d += [&](const ping_signal&) {
+            d -= callable;
+            during = resource.use_count();
+        };
+        d += callable;
+
+        d.dispatch(ping_signal());
+        CHECK(during == 3);
+        CHECK(resource.use_count() == 2);
+        CHECK(*resource == 0);
+    }
+
+    void listener_removing_itself_finishes_running() {
+        dispatcher d;
+        std::shared_ptr<int> resource = std::make_shared<int>(0);
+        std::function<void(const ping_signal&)> self;
+
+        add_bystanders(d);
+        self = [&d, &self, resource](const ping_signal&) {
+            d -= self;
+
+            // Still running on our own captures.
+            ++*resource;
+        };
+        d += self;
+        CHECK(resource.use_count() == 3);
+
+        d.dispatch(ping_signal());
+        CHECK(*resource == 1);
+        CHECK(resource.use_count() == 2);
+    }
+
+    //----------------------------------
+    //  Removal by Handle
+    //----------------------------------
+
+    void remove_by_handle_releases_captures() {
+        dispatcher d;
+        std::shared_ptr<int> resource = std::make_shared<int>(0);
+
+        add_bystanders(d);
+        subscription handle = d += [resource](const ping_signal&) { ++*resource; };
+        CHECK(resource.use_count() == 2);
+
+        CHECK(d.remove(handle));
+        CHECK(resource.use_count() == 1);
+    }
+
+    void remove_by_handle_during_dispatch_releases_captures_after_dispatch() {
+        dispatcher d;
+        std::shared_ptr<int> resource = std::make_shared<int>(0);
+        subscription handle;
+        long during = 0;
+
+        add_bystanders(d);
+        d += [&](const ping_signal&) {
+            d -= handle;
+            during = resource.use_count();
+        };
+        handle = d += [resource](const ping_signal&) { ++*resource; };
+
+        d.dispatch(ping_signal());
+        CHECK(during == 2);
+        CHECK(resource.use_count() == 1);
+        CHECK(*resource == 0);
+    }
+
+    void cancelled_add_releases_captures() {
+        dispatcher d;
+        std::shared_ptr<int> resource = std::make_shared<int>(0);
+        long during = 0;
+
+        d += [&](const ping_signal&) {
+            subscription handle = d += [resource](const ping_signal&) { ++*resource; };
+            d.remove(handle);
+            during = resource.use_count();
+        };
+
+        d.dispatch(ping_signal());
+        CHECK(during == 1);
+        CHECK(resource.use_count() == 1);
+    }
+
+    void scoped_subscription_releases_captures() {
+        dispatcher d;
+        std::shared_ptr<int> resource = std::make_shared<int>(0);
+
+        add_bystanders(d);
+        {
+            scoped_subscription scope(d, d += [resource](const ping_signal&) { ++*resource; });
+            CHECK(resource.use_count() == 2);
+        }
+        CHECK(resource.use_count() == 1);
+    }
+
+    void keyed_remove_releases_captures() {
+        dispatcher d;
+        std::shared_ptr<int> resource = std::make_shared<int>(0);
+
+        subscription handle = d += for_key(7, [resource](const keyed_signal&) { ++*resource; });
+        d += for_key(7, [](const keyed_signal&) { });
+        d += for_key(7, [](const keyed_signal&) { });
+        CHECK(resource.use_count() == 2);
+
+        CHECK(d.remove(handle));
+        CHECK(resource.use_count() == 1);
+    }
+
+};
+
+int main() {
+    remove_by_address_releases_captures();
+    remove_by_address_during_dispatch_releases_captures_after_dispatch();
+    listener_removing_itself_finishes_running();
+    remove_by_handle_releases_captures();
+    remove_by_handle_during_dispatch_releases_captures_after_dispatch();
+    cancelled_add_releases_captures();
+    scoped_subscription_releases_captures();
+    keyed_remove_releases_captures();
+
+    return dispatch_test::result();
+}
@@ -0,0 +1,207 @@
+////////////////////////////////////////////////////////////////////////////////
+//
+// The MIT License (MIT)
+//
+// Copyright (c) 2015 Matt Bolt
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+////////////////////////////////////////////////////////////////////////////////
+
+// Sticky signal types: the latest value is kept and replayed to listeners as they're added.
+
+#include <cstdint>
+#include <vector>
+#include "dispatcher.h"
+#include "check.h"
+
+using namespace dispatch;
+
+struct status_signal : public signal {
+    int value;
+
+    status_signal(int _value) : signal(), value(_value) { }
+
+    bool operator==(const status_signal& other) const {
+        return value == other.value;
+    }
+};
+
+struct entity_signal : public signal {
+    std::uint32_t entity;
+    int value;
+
+    entity_signal(std::uint32_t _entity, int _value) : signal(), entity(_entity), value(_value) { }
+};
+
+DISPATCH_SIGNAL_KEY(entity_signal, entity)
+
+namespace {
+
+    void replays_the_latest_value_on_add() {
+        dispatcher d;
+        std::vector<int> early;
+        std::vector<int> late;
+
+        d.set_sticky<status_signal>();
+        CHECK(d.latest<status_signal>() == nullptr);
+
+        d += [&early](const status_signal& s) { early.push_back(s.value); };
+        CHECK(early.empty());
+
+        d.dispatch(status_signal(1));
+        d.dispatch(status_signal(2));
+        CHECK(d.latest<status_signal>() != nullptr && d.latest<status_signal>()->value == 2);
+
+        d += [&late](const status_signal& s) { late.push_back(s.value); };
+        CHECK(late == std::vector<int>({ 2 }));
+
+        d.dispatch(status_signal(3));
+        CHECK(early == std::vector<int>({ 1, 2, 3 }));
+        CHECK(late == std::vector<int>({ 2, 3 }));
+    }
+
+    void replays_to_keyed_listeners_with_a_matching_key() {
+        dispatcher d;
+        std::vector<int> first;
+        std::vector<int> second;
+
+        d.set_sticky<entity_signal>();
+        d.dispatch(entity_signal(1, 10));
+
+        d += for_key(2u, [&second](const entity_signal& s) { second.push_back(s.value); });
+        d += for_key(1u, [&first](const entity_signal& s) { first.push_back(s.value); });
+        CHECK(first == std::vector<int>({ 10 }));
+        CHECK(second.empty());
+    }
+
+    void replays_to_batch_listeners_as_a_batch_of_one() {
+        dispatcher d;
+        std::vector<std::size_t> counts;
+        std::vector<int> values;
+
+        d.set_sticky<status_signal>();
+        d.dispatch(status_signal(4));
+
+        d += [&](const status_signal* batch, std::size_t count) {
+            counts.push_back(count);
+            for (std::size_t i = 0; i < count; ++i) {
+                values.push_back(batch[i].value);
+            }
+        };
+        CHECK(counts == std::vector<std::size_t>({ 1 }));
+        CHECK(values == std::vector<int>({ 4 }));
+
+        // A batch keeps its last value.
+        status_signal batch[] = { status_signal(5), status_signal(6) };
+        d.dispatch_batch(batch, 2);
+        CHECK(d.latest<status_signal>()->value == 6);
+    }
+
+    void skips_unchanged_values() {
+        dispatcher d;
+        std::vector<int> seen;
+
+        d.set_sticky<status_signal>(coalesce_unchanged);
+        d += [&seen](const status_signal& s) { seen.push_back(s.value); };
+
+        d.dispatch(status_signal(1));
+        d.dispatch(status_signal(1));
+        d.dispatch(status_signal(2));
+        d.dispatch(status_signal(2));
+        d.dispatch(status_signal(1));
+        CHECK(seen == std::vector<int>({ 1, 2, 1 }));
+    }
+
+    void clearing_stops_replaying() {
+        dispatcher d;
+        int replays = 0;
+
+        d.set_sticky<status_signal>();
+        d.dispatch(status_signal(1));
+        d.clear_sticky<status_signal>();
+        CHECK(d.latest<status_signal>() == nullptr);
+
+        d += [&replays](const status_signal&) { ++replays; };
+        CHECK(replays == 0);
+
+        d.dispatch(status_signal(2));
+        CHECK(replays == 1);
+        CHECK(d.latest<status_signal>() == nullptr);
+    }
+
+    void listeners_may_dispatch_from_their_replay() {
+        dispatcher d;
+        std::vector<int> existing;
+        std::vector<int> replayed;
+
+        d.set_sticky<status_signal>();
+        d += [&existing](const status_signal& s) { existing.push_back(s.value); };
+        d.dispatch(status_signal(1));
+
+        // The new listener isn't subscribed during its replay, so only the existing one receives the dispatch,
+        // and the value it was replayed stays as it was.
+        bool replaying = true;
+        d += [&](const status_signal& s) {
+            if (replaying) {
+                replaying = false;
+                d.dispatch(status_signal(s.value + 1));
+            }
+            replayed.push_back(s.value);
+        };
+
+        CHECK(existing == std::vector<int>({ 1, 2 }));
+        CHECK(replayed == std::vector<int>({ 1 }));
+        CHECK(d.latest<status_signal>()->value == 2);
+
+        d.dispatch(status_signal(3));
+        CHECK(replayed == std::vector<int>({ 1, 3 }));
+    }
+
+    void consuming_a_replay_doesnt_unsubscribe() {
+        dispatcher d;
+        int calls = 0;
+
+        d.set_sticky<status_signal>();
+        d.dispatch(status_signal(1));
+
+        d += [&calls](const status_signal&) {
+            ++calls;
+            consume();
+        };
+        CHECK(calls == 1);
+        CHECK(d.memory_usage().subscriptions == 1);
+
+        d.dispatch(status_signal(2));
+        CHECK(calls == 2);
+    }
+
+};
+
+int main() {
+    replays_the_latest_value_on_add();
+    replays_to_keyed_listeners_with_a_matching_key();
+    replays_to_batch_listeners_as_a_batch_of_one();
+    skips_unchanged_values();
+    clearing_stops_replaying();
+    listeners_may_dispatch_from_their_replay();
+    consuming_a_replay_doesnt_unsubscribe();
+
+    return dispatch_test::result();
+}